@@ -0,0 +1,241 @@
+//Tencent is pleased to support the open source community by making FeatherCNN available.
+
+//Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+
+//Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+//in compliance with the License. You may obtain a copy of the License at
+//
+//https://opensource.org/licenses/BSD-3-Clause
+//
+//Unless required by applicable law or agreed to in writing, software distributed
+//under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//CONDITIONS OF ANY KIND, either express or implied. See the License for the
+//specific language governing permissions and limitations under the License.
+
+#include "deconv.h"
+
+#include <arm_neon.h>
+
+#ifdef __APPLE__
+#else
+#include <omp.h>
+#endif
+
+//Rounds towards minus infinity, b > 0.
+static inline int floor_div(int a, int b)
+{
+    return (a >= 0) ? a / b : -((-a + b - 1) / b);
+}
+
+static inline int ceil_div(int a, int b)
+{
+    return -floor_div(-a, b);
+}
+
+template<bool fuseRelu>
+static inline float32x4_t activate(float32x4_t v)
+{
+    if (fuseRelu)
+        v = vmaxq_f32(v, vdupq_n_f32(0.f));
+    return v;
+}
+
+template<bool fuseRelu>
+static inline float activate(float v)
+{
+    if (fuseRelu)
+        v = (v > 0.f) ? v : 0.f;
+    return v;
+}
+
+template<bool fuseBias, bool fuseRelu>
+static void col2im_generic(float* output, const float* col, const int channels, const int input_h, const int input_w,
+                           const int output_h, const int output_w, const int kernel_h, const int kernel_w,
+                           const int stride_h, const int stride_w, const int pad_h, const int pad_w,
+                           const int dilation_h, const int dilation_w, const float* bias, const int num_threads)
+{
+    const int plane = input_h * input_w;
+    //Aim at ~16KB of output per band.
+    int band_rows = 4096 / output_w;
+    band_rows = (band_rows < 1) ? 1 : band_rows;
+    const int num_bands = (output_h + band_rows - 1) / band_rows;
+    #pragma omp parallel for num_threads(num_threads) collapse(2) schedule(static)
+    for (int c = 0; c < channels; ++c)
+    {
+        for (int band = 0; band < num_bands; ++band)
+        {
+            const int row_begin = band * band_rows;
+            const int row_end = (row_begin + band_rows < output_h) ? row_begin + band_rows : output_h;
+            float* outp = output + (c * output_h + row_begin) * output_w;
+            const float b = fuseBias ? bias[c] : 0.f;
+            for (int i = 0; i < (row_end - row_begin) * output_w; ++i)
+                outp[i] = b;
+            for (int u = 0; u < kernel_h; ++u)
+            {
+                //Input rows whose tap u lands in the band.
+                const int offset_h = u * dilation_h - pad_h;
+                int y_begin = ceil_div(row_begin - offset_h, stride_h);
+                int y_end = floor_div(row_end - 1 - offset_h, stride_h) + 1;
+                y_begin = (y_begin < 0) ? 0 : y_begin;
+                y_end = (y_end > input_h) ? input_h : y_end;
+                for (int y = y_begin; y < y_end; ++y)
+                {
+                    float* out_row = outp + (y * stride_h + offset_h - row_begin) * output_w;
+                    for (int v = 0; v < kernel_w; ++v)
+                    {
+                        const int offset_w = v * dilation_w - pad_w;
+                        int x_begin = ceil_div(-offset_w, stride_w);
+                        int x_end = floor_div(output_w - 1 - offset_w, stride_w) + 1;
+                        x_begin = (x_begin < 0) ? 0 : x_begin;
+                        x_end = (x_end > input_w) ? input_w : x_end;
+                        const float* col_row = col + ((c * kernel_h + u) * kernel_w + v) * plane + y * input_w;
+                        float* dst = out_row + offset_w;
+                        int x = x_begin;
+                        if (stride_w == 1)
+                        {
+                            for (; x + 4 <= x_end; x += 4)
+                                vst1q_f32(dst + x, vaddq_f32(vld1q_f32(dst + x), vld1q_f32(col_row + x)));
+                        }
+                        for (; x < x_end; ++x)
+                            dst[x * stride_w] += col_row[x];
+                    }
+                }
+            }
+            if (fuseRelu)
+            {
+                int i = 0;
+                for (; i + 4 <= (row_end - row_begin) * output_w; i += 4)
+                    vst1q_f32(outp + i, activate<true>(vld1q_f32(outp + i)));
+                for (; i < (row_end - row_begin) * output_w; ++i)
+                    outp[i] = activate<true>(outp[i]);
+            }
+        }
+    }
+}
+
+//Kernel 2 stride 2 without padding: every output pixel gets exactly one tap, the two taps of a kernel row interleave.
+template<bool fuseBias, bool fuseRelu>
+static void col2im_k2s2(float* output, const float* col, const int channels, const int input_h, const int input_w,
+                        const int output_h, const int output_w, const float* bias, const int num_threads)
+{
+    const int plane = input_h * input_w;
+    #pragma omp parallel for num_threads(num_threads) collapse(2) schedule(static)
+    for (int c = 0; c < channels; ++c)
+    {
+        for (int oy = 0; oy < output_h; ++oy)
+        {
+            const int y = oy / 2;
+            const int u = oy % 2;
+            const float b = fuseBias ? bias[c] : 0.f;
+            const float32x4_t vb = vdupq_n_f32(b);
+            const float* c0 = col + (c * 4 + u * 2) * plane + y * input_w;
+            const float* c1 = c0 + plane;
+            float* outp = output + (c * output_h + oy) * output_w;
+            int x = 0;
+            for (; x + 4 <= input_w; x += 4)
+            {
+                float32x4x2_t v;
+                v.val[0] = activate<fuseRelu>(vaddq_f32(vld1q_f32(c0 + x), vb));
+                v.val[1] = activate<fuseRelu>(vaddq_f32(vld1q_f32(c1 + x), vb));
+                vst2q_f32(outp + 2 * x, v);
+            }
+            for (; x < input_w; ++x)
+            {
+                outp[2 * x] = activate<fuseRelu>(c0[x] + b);
+                outp[2 * x + 1] = activate<fuseRelu>(c1[x] + b);
+            }
+        }
+    }
+}
+
+template<bool fuseRelu>
+static inline void k4s2p1_column(float* outp, const float* const* rows, const int taps, const int plane, const int input_w, const int n, const float b)
+{
+    float even = b;
+    float odd = b;
+    for (int t = 0; t < taps; ++t)
+    {
+        even += rows[t][plane + n];
+        if (n > 0)
+            even += rows[t][3 * plane + n - 1];
+        odd += rows[t][2 * plane + n];
+        if (n + 1 < input_w)
+            odd += rows[t][n + 1];
+    }
+    outp[2 * n] = activate<fuseRelu>(even);
+    outp[2 * n + 1] = activate<fuseRelu>(odd);
+}
+
+/*
+ * Kernel 4 stride 2 pad 1: output row 2m takes kernel rows 1 and 3 of input rows m and m - 1,
+ * row 2m + 1 kernel rows 0 and 2 of input rows m + 1 and m. Columns split the same way, so even
+ * and odd outputs are each the sum of two shifted col rows per kernel row.
+ */
+template<bool fuseBias, bool fuseRelu>
+static void col2im_k4s2p1(float* output, const float* col, const int channels, const int input_h, const int input_w,
+                          const int output_h, const int output_w, const float* bias, const int num_threads)
+{
+    const int plane = input_h * input_w;
+    #pragma omp parallel for num_threads(num_threads) collapse(2) schedule(static)
+    for (int c = 0; c < channels; ++c)
+    {
+        for (int oy = 0; oy < output_h; ++oy)
+        {
+            const float b = fuseBias ? bias[c] : 0.f;
+            const float32x4_t vb = vdupq_n_f32(b);
+            //(kernel row, input row) pairs landing on this output row.
+            int taps = 0;
+            const float* rows[2];
+            const int m = oy / 2;
+            const int tap_u[2] = {(oy % 2) ? 0 : 1, (oy % 2) ? 2 : 3};
+            const int tap_y[2] = {(oy % 2) ? m + 1 : m, (oy % 2) ? m : m - 1};
+            for (int t = 0; t < 2; ++t)
+            {
+                if (tap_y[t] >= 0 && tap_y[t] < input_h)
+                    rows[taps++] = col + (c * 16 + tap_u[t] * 4) * plane + tap_y[t] * input_w;
+            }
+            float* outp = output + (c * output_h + oy) * output_w;
+            //Even column 2n: taps 1 of n and 3 of n - 1. Odd column 2n + 1: taps 0 of n + 1 and 2 of n.
+            k4s2p1_column<fuseRelu>(outp, rows, taps, plane, input_w, 0, b);
+            int n = 1;
+            for (; n + 5 <= input_w; n += 4)
+            {
+                float32x4x2_t v;
+                v.val[0] = vb;
+                v.val[1] = vb;
+                for (int t = 0; t < taps; ++t)
+                {
+                    v.val[0] = vaddq_f32(v.val[0], vaddq_f32(vld1q_f32(rows[t] + plane + n), vld1q_f32(rows[t] + 3 * plane + n - 1)));
+                    v.val[1] = vaddq_f32(v.val[1], vaddq_f32(vld1q_f32(rows[t] + n + 1), vld1q_f32(rows[t] + 2 * plane + n)));
+                }
+                v.val[0] = activate<fuseRelu>(v.val[0]);
+                v.val[1] = activate<fuseRelu>(v.val[1]);
+                vst2q_f32(outp + 2 * n, v);
+            }
+            for (; n < input_w; ++n)
+                k4s2p1_column<fuseRelu>(outp, rows, taps, plane, input_w, n, b);
+        }
+    }
+}
+
+template<bool fuseBias, bool fuseRelu>
+void col2im(float* output, const float* col, const int channels, const int input_h, const int input_w,
+            const int output_h, const int output_w, const int kernel_h, const int kernel_w,
+            const int stride_h, const int stride_w, const int pad_h, const int pad_w,
+            const int dilation_h, const int dilation_w, const float* bias, const int num_threads)
+{
+    const bool upsample_2x = (stride_h == 2 && stride_w == 2 && dilation_h == 1 && dilation_w == 1
+                              && kernel_h == kernel_w && output_h == 2 * input_h && output_w == 2 * input_w);
+    if (upsample_2x && kernel_h == 2 && pad_h == 0 && pad_w == 0)
+        col2im_k2s2<fuseBias, fuseRelu>(output, col, channels, input_h, input_w, output_h, output_w, bias, num_threads);
+    else if (upsample_2x && kernel_h == 4 && pad_h == 1 && pad_w == 1)
+        col2im_k4s2p1<fuseBias, fuseRelu>(output, col, channels, input_h, input_w, output_h, output_w, bias, num_threads);
+    else
+        col2im_generic<fuseBias, fuseRelu>(output, col, channels, input_h, input_w, output_h, output_w, kernel_h, kernel_w,
+                                           stride_h, stride_w, pad_h, pad_w, dilation_h, dilation_w, bias, num_threads);
+}
+
+template void col2im<false, false>(float*, const float*, const int, const int, const int, const int, const int, const int, const int, const int, const int, const int, const int, const int, const int, const float*, const int);
+template void col2im<false, true>(float*, const float*, const int, const int, const int, const int, const int, const int, const int, const int, const int, const int, const int, const int, const int, const float*, const int);
+template void col2im<true, false>(float*, const float*, const int, const int, const int, const int, const int, const int, const int, const int, const int, const int, const int, const int, const int, const float*, const int);
+template void col2im<true, true>(float*, const float*, const int, const int, const int, const int, const int, const int, const int, const int, const int, const int, const int, const int, const int, const float*, const int);
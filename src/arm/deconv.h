@@ -0,0 +1,29 @@
+//Tencent is pleased to support the open source community by making FeatherCNN available.
+
+//Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+
+//Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+//in compliance with the License. You may obtain a copy of the License at
+//
+//https://opensource.org/licenses/BSD-3-Clause
+//
+//Unless required by applicable law or agreed to in writing, software distributed
+//under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//CONDITIONS OF ANY KIND, either express or implied. See the License for the
+//specific language governing permissions and limitations under the License.
+
+#pragma once
+
+/*
+ * Scatters the GEMM output of a deconvolution into the output map. col holds one
+ * input_h x input_w plane per (channel, kernel row, kernel column), tap (u, v) of input pixel
+ * (y, x) lands on (y * stride_h - pad_h + u * dilation_h, x * stride_w - pad_w + v * dilation_w).
+ * Output rows are produced band by band so that the accumulated band stays in cache. Kernel 2
+ * stride 2 without padding and kernel 4 stride 2 pad 1 take dedicated paths.
+ * Bias (per channel) and ReLU are applied as the output is written.
+ */
+template<bool fuseBias, bool fuseRelu>
+void col2im(float* output, const float* col, const int channels, const int input_h, const int input_w,
+            const int output_h, const int output_w, const int kernel_h, const int kernel_w,
+            const int stride_h, const int stride_w, const int pad_h, const int pad_w,
+            const int dilation_h, const int dilation_w, const float* bias, const int num_threads);
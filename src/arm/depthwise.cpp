@@ -1165,3 +1165,137 @@ void dwConv(float* output, float* input, int inw, int inh, int stridew, int stri
         }
     }
 }
+
+static inline float32x4_t dw_mla(float32x4_t sum, float32x4_t v, float k)
+{
+#ifdef __aarch64__
+    return vfmaq_n_f32(sum, v, k);
+#else
+    return vmlaq_n_f32(sum, v, k);
+#endif
+}
+
+/*
+ * Row band of a depthwise convolution for fused executors, see depthwise.h.
+ */
+void dwConvRows(float* output, const float* input, int channels, int inw, int frame_stride, int stridew, int strideh, const float* kernel, int kw, int kh, int dilationw, int dilationh, int outw, int row_begin, int row_end, const float* bias, bool relu, int nThreads)
+{
+    const int rows = row_end - row_begin;
+    #pragma omp parallel for num_threads(nThreads) schedule(static) collapse(2)
+    for (int g = 0; g < channels; ++g)
+    {
+        for (int i = 0; i < rows; ++i)
+        {
+            const float* kp = kernel + kw * kh * g;
+            const float* r0 = input + g * frame_stride + (row_begin + i) * strideh * inw;
+            float* outp = output + (g * rows + i) * outw;
+            const float b = bias ? bias[g] : 0.f;
+            int j = 0;
+            if (kw == 3 && kh == 3 && stridew == 1)
+            {
+                //Dilated taps are just further apart.
+                const int dw = dilationw;
+                const float* r1 = r0 + dilationh * inw;
+                const float* r2 = r1 + dilationh * inw;
+                for (; j + 4 <= outw; j += 4)
+                {
+                    float32x4_t sum = vdupq_n_f32(b);
+                    sum = dw_mla(sum, vld1q_f32(r0 + j), kp[0]);
+                    sum = dw_mla(sum, vld1q_f32(r0 + j + dw), kp[1]);
+                    sum = dw_mla(sum, vld1q_f32(r0 + j + 2 * dw), kp[2]);
+                    sum = dw_mla(sum, vld1q_f32(r1 + j), kp[3]);
+                    sum = dw_mla(sum, vld1q_f32(r1 + j + dw), kp[4]);
+                    sum = dw_mla(sum, vld1q_f32(r1 + j + 2 * dw), kp[5]);
+                    sum = dw_mla(sum, vld1q_f32(r2 + j), kp[6]);
+                    sum = dw_mla(sum, vld1q_f32(r2 + j + dw), kp[7]);
+                    sum = dw_mla(sum, vld1q_f32(r2 + j + 2 * dw), kp[8]);
+                    if (relu)
+                        sum = vmaxq_f32(sum, vdupq_n_f32(0.f));
+                    vst1q_f32(outp + j, sum);
+                }
+            }
+            else if (kw == 3 && kh == 3 && stridew == 2 && dilationw == 1 && dilationh == 1)
+            {
+                const float* r1 = r0 + inw;
+                const float* r2 = r1 + inw;
+                //vld2q reads 8 floats from the third tap on.
+                for (; j + 4 <= outw && 2 * j + 10 <= inw; j += 4)
+                {
+                    float32x4_t sum = vdupq_n_f32(b);
+                    float32x4x2_t v0 = vld2q_f32(r0 + 2 * j);
+                    float32x4x2_t v1 = vld2q_f32(r1 + 2 * j);
+                    float32x4x2_t v2 = vld2q_f32(r2 + 2 * j);
+                    sum = dw_mla(sum, v0.val[0], kp[0]);
+                    sum = dw_mla(sum, v0.val[1], kp[1]);
+                    sum = dw_mla(sum, vld2q_f32(r0 + 2 * j + 2).val[0], kp[2]);
+                    sum = dw_mla(sum, v1.val[0], kp[3]);
+                    sum = dw_mla(sum, v1.val[1], kp[4]);
+                    sum = dw_mla(sum, vld2q_f32(r1 + 2 * j + 2).val[0], kp[5]);
+                    sum = dw_mla(sum, v2.val[0], kp[6]);
+                    sum = dw_mla(sum, v2.val[1], kp[7]);
+                    sum = dw_mla(sum, vld2q_f32(r2 + 2 * j + 2).val[0], kp[8]);
+                    if (relu)
+                        sum = vmaxq_f32(sum, vdupq_n_f32(0.f));
+                    vst1q_f32(outp + j, sum);
+                }
+            }
+            for (; j < outw; ++j)
+            {
+                const float* inp = r0 + j * stridew;
+                float convSum = b;
+                for (int m = 0; m < kh; m++)
+                {
+                    for (int n = 0; n < kw; n++)
+                    {
+                        convSum += inp[m * dilationh * inw + n * dilationw] * kp[m * kw + n];
+                    }
+                }
+                outp[j] = (relu && convSum < 0.f) ? 0.f : convSum;
+            }
+        }
+    }
+}
+
+void dwConvNC4HW4(float* output, const float* input, int channels, int inh, int inw, int outh, int outw, const float* kernel, int kh, int kw, int strideh, int stridew, int dilationh, int dilationw, int padh, int padw, const float* bias, bool relu, int nThreads)
+{
+    const int blocks = (channels + 3) / 4;
+    const float32x4_t vZero = vdupq_n_f32(0.f);
+    #pragma omp parallel for num_threads(nThreads) schedule(static) collapse(2)
+    for (int b = 0; b < blocks; ++b)
+    {
+        for (int i = 0; i < outh; ++i)
+        {
+            const float* inb = input + b * inh * inw * 4;
+            const float* kb = kernel + b * kh * kw * 4;
+            float* outp = output + (b * outh + i) * outw * 4;
+            const float32x4_t vBias = bias ? vld1q_f32(bias + b * 4) : vZero;
+            //Padding is implicit, only the taps falling into the input are accumulated.
+            const int y0 = i * strideh - padh;
+            const int m0 = (y0 < 0) ? (-y0 + dilationh - 1) / dilationh : 0;
+            const int m1 = (y0 + (kh - 1) * dilationh >= inh) ? (inh - y0 + dilationh - 1) / dilationh : kh;
+            for (int j = 0; j < outw; ++j)
+            {
+                const int x0 = j * stridew - padw;
+                const int n0 = (x0 < 0) ? (-x0 + dilationw - 1) / dilationw : 0;
+                const int n1 = (x0 + (kw - 1) * dilationw >= inw) ? (inw - x0 + dilationw - 1) / dilationw : kw;
+                float32x4_t sum = vBias;
+                for (int m = m0; m < m1; ++m)
+                {
+                    const float* inp = inb + (y0 + m * dilationh) * inw * 4;
+                    const float* kp = kb + m * kw * 4;
+                    for (int n = n0; n < n1; ++n)
+                    {
+#ifdef __aarch64__
+                        sum = vfmaq_f32(sum, vld1q_f32(inp + (x0 + n * dilationw) * 4), vld1q_f32(kp + n * 4));
+#else
+                        sum = vmlaq_f32(sum, vld1q_f32(inp + (x0 + n * dilationw) * 4), vld1q_f32(kp + n * 4));
+#endif
+                    }
+                }
+                if (relu)
+                    sum = vmaxq_f32(sum, vZero);
+                vst1q_f32(outp + j * 4, sum);
+            }
+        }
+    }
+}
@@ -18,3 +18,16 @@
 
 void globalDwConv(float* output, const float* input, int input_channels, int inw, int inh, float* kernel, int group, int nThreads);
 void dwConv(float* output, float* input, int inw, int inh, int stridew, int strideh, float* kernel, int kw, int kh, int group, int nThreads);
+
+/*
+ * Output rows [row_begin, row_end) of a depthwise convolution over a padded input whose channels
+ * are frame_stride floats apart. Output holds (row_end - row_begin) * outw floats per channel,
+ * bias may be NULL. Kernel taps are dilationw / dilationh pixels apart.
+ */
+void dwConvRows(float* output, const float* input, int channels, int inw, int frame_stride, int stridew, int strideh, const float* kernel, int kw, int kh, int dilationw, int dilationh, int outw, int row_begin, int row_end, const float* bias, bool relu, int nThreads);
+
+/*
+ * Depthwise convolution on NC4HW4 data with implicit zero padding.
+ * Kernel is packed as [channels / 4][kh * kw][4], kernel and bias are zero padded to a multiple of four channels.
+ */
+void dwConvNC4HW4(float* output, const float* input, int channels, int inh, int inw, int outh, int outw, const float* kernel, int kh, int kw, int strideh, int stridew, int dilationh, int dilationw, int padh, int padw, const float* bias, bool relu, int nThreads);
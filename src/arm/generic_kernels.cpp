@@ -114,6 +114,115 @@ void add_relu(float* dst, const float* A, const float* B, const size_t len, cons
 template void add_relu<true>(float* dst, const float* A, const float* B, const size_t len, const size_t num_threads);
 template void add_relu<false>(float* dst, const float* A, const float* B, const size_t len, const size_t num_threads);
 
+void pack_nc4hw4(float* dst, const float* src, const size_t channels, const size_t stride, const size_t num_threads)
+{
+    const int blocks = (channels + 3) / 4;
+    #pragma omp parallel for num_threads(num_threads) schedule(static)
+    for (int b = 0; b < blocks; ++b)
+    {
+        float* dp = dst + b * stride * 4;
+        const int c0 = b * 4;
+        if (c0 + 4 <= channels)
+        {
+            const float* s0 = src + c0 * stride;
+            const float* s1 = s0 + stride;
+            const float* s2 = s1 + stride;
+            const float* s3 = s2 + stride;
+            int j = 0;
+            for (; j + 4 <= stride; j += 4)
+            {
+                float32x4x4_t v;
+                v.val[0] = vld1q_f32(s0 + j);
+                v.val[1] = vld1q_f32(s1 + j);
+                v.val[2] = vld1q_f32(s2 + j);
+                v.val[3] = vld1q_f32(s3 + j);
+                vst4q_f32(dp + j * 4, v);
+            }
+            for (; j < stride; ++j)
+            {
+                dp[j * 4] = s0[j];
+                dp[j * 4 + 1] = s1[j];
+                dp[j * 4 + 2] = s2[j];
+                dp[j * 4 + 3] = s3[j];
+            }
+        }
+        else
+        {
+            for (int j = 0; j < stride; ++j)
+                for (int k = 0; k < 4; ++k)
+                    dp[j * 4 + k] = (c0 + k < channels) ? src[(c0 + k) * stride + j] : 0.f;
+        }
+    }
+}
+
+void unpack_nc4hw4(float* dst, const float* src, const size_t channels, const size_t stride, const size_t num_threads)
+{
+    const int blocks = (channels + 3) / 4;
+    #pragma omp parallel for num_threads(num_threads) schedule(static)
+    for (int b = 0; b < blocks; ++b)
+    {
+        const float* sp = src + b * stride * 4;
+        const int c0 = b * 4;
+        if (c0 + 4 <= channels)
+        {
+            float* d0 = dst + c0 * stride;
+            float* d1 = d0 + stride;
+            float* d2 = d1 + stride;
+            float* d3 = d2 + stride;
+            int j = 0;
+            for (; j + 4 <= stride; j += 4)
+            {
+                float32x4x4_t v = vld4q_f32(sp + j * 4);
+                vst1q_f32(d0 + j, v.val[0]);
+                vst1q_f32(d1 + j, v.val[1]);
+                vst1q_f32(d2 + j, v.val[2]);
+                vst1q_f32(d3 + j, v.val[3]);
+            }
+            for (; j < stride; ++j)
+            {
+                d0[j] = sp[j * 4];
+                d1[j] = sp[j * 4 + 1];
+                d2[j] = sp[j * 4 + 2];
+                d3[j] = sp[j * 4 + 3];
+            }
+        }
+        else
+        {
+            for (int k = 0; c0 + k < channels; ++k)
+                for (int j = 0; j < stride; ++j)
+                    dst[(c0 + k) * stride + j] = sp[j * 4 + k];
+        }
+    }
+}
+
+template<bool fuse_relu>
+void affine_nc4hw4(const size_t channels, const size_t stride, const float* scale_data, const float* bias_data, const float* input, float* output, const size_t num_threads)
+{
+    const int blocks = (channels + 3) / 4;
+    const float32x4_t vZero = vdupq_n_f32(0.f);
+    #pragma omp parallel for num_threads(num_threads) schedule(static)
+    for (int b = 0; b < blocks; ++b)
+    {
+        const float32x4_t vScale = vld1q_f32(scale_data + b * 4);
+        const float32x4_t vBias = vld1q_f32(bias_data + b * 4);
+        const float* ip = input + b * stride * 4;
+        float* op = output + b * stride * 4;
+        for (int j = 0; j < stride; ++j)
+        {
+#ifdef __aarch64__
+            float32x4_t v = vfmaq_f32(vBias, vld1q_f32(ip + j * 4), vScale);
+#else
+            float32x4_t v = vmlaq_f32(vBias, vld1q_f32(ip + j * 4), vScale);
+#endif
+            if (fuse_relu)
+                v = vmaxq_f32(v, vZero);
+            vst1q_f32(op + j * 4, v);
+        }
+    }
+}
+template void affine_nc4hw4<true>(const size_t, const size_t, const float*, const float*, const float*, float*, const size_t);
+template void affine_nc4hw4<false>(const size_t, const size_t, const float*, const float*, const float*, float*, const size_t);
+
 void vsub(float* dst, float* A, float* B, size_t len, size_t num_threads)
 {
     #pragma omp parallel for num_threads(num_threads) schedule(static)
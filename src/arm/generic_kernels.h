@@ -21,6 +21,14 @@ void pad_input(float* padded, const float* input, const size_t input_channels, c
 template<bool fuse_relu>
 void add_relu(float* dst, const float* A, const float* B, const size_t len, const size_t num_threads);
 
+//Conversions between NCHW and NC4HW4, stride is the number of pixels per channel.
+void pack_nc4hw4(float* dst, const float* src, const size_t channels, const size_t stride, const size_t num_threads);
+void unpack_nc4hw4(float* dst, const float* src, const size_t channels, const size_t stride, const size_t num_threads);
+
+//Per channel y = scale * x + bias on NC4HW4 data, parameters padded to a multiple of four.
+template<bool fuse_relu>
+void affine_nc4hw4(const size_t channels, const size_t stride, const float* scale_data, const float* bias_data, const float* input, float* output, const size_t num_threads);
+
 template<bool has_bias>
 void scale(const size_t channels, const size_t stride, const float* bias_data, const float* scale_data, const float* input, float* output, const size_t num_threads);
 
@@ -0,0 +1,201 @@
+//Tencent is pleased to support the open source community by making FeatherCNN available.
+
+//Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+
+//Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+//in compliance with the License. You may obtain a copy of the License at
+//
+//https://opensource.org/licenses/BSD-3-Clause
+//
+//Unless required by applicable law or agreed to in writing, software distributed
+//under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//CONDITIONS OF ANY KIND, either express or implied. See the License for the
+//specific language governing permissions and limitations under the License.
+
+#include "lrn.h"
+#include "power.h"
+
+#include <math.h>
+#include <string.h>
+#include <arm_neon.h>
+
+#ifdef __APPLE__
+#else
+#include <omp.h>
+#endif
+
+//output = input * (shift + scale * sum) ^ -beta over n elements.
+static void lrn_apply(float* output, const float* input, const float* sum, const int n, const float shift, const float scale, const float beta)
+{
+    const float32x4_t v_shift = vdupq_n_f32(shift);
+    const float32x4_t v_beta = vdupq_n_f32(-beta);
+    int i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        //Sliding sums may drift slightly below zero.
+        float32x4_t s = vmaxq_f32(vld1q_f32(sum + i), vdupq_n_f32(0.f));
+        float32x4_t base = vmlaq_n_f32(v_shift, s, scale);
+        vst1q_f32(output + i, vmulq_f32(vld1q_f32(input + i), pow_ps(base, v_beta)));
+    }
+    for (; i < n; ++i)
+    {
+        float s = (sum[i] > 0.f) ? sum[i] : 0.f;
+        output[i] = input[i] * powf(shift + scale * s, -beta);
+    }
+}
+
+//sum += x^2 or sum -= x^2
+template<bool add>
+static inline void accumulate_squares(float* sum, const float* x, const int n)
+{
+    int i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        float32x4_t v = vld1q_f32(x + i);
+        float32x4_t s = vld1q_f32(sum + i);
+        vst1q_f32(sum + i, add ? vmlaq_f32(s, v, v) : vmlsq_f32(s, v, v));
+    }
+    for (; i < n; ++i)
+        sum[i] += add ? x[i] * x[i] : -x[i] * x[i];
+}
+
+//sum += x or sum -= x
+template<bool add>
+static inline void accumulate_rows(float* sum, const float* x, const int n)
+{
+    int i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        float32x4_t s = vld1q_f32(sum + i);
+        vst1q_f32(sum + i, add ? vaddq_f32(s, vld1q_f32(x + i)) : vsubq_f32(s, vld1q_f32(x + i)));
+    }
+    for (; i < n; ++i)
+        sum[i] += add ? x[i] : -x[i];
+}
+
+void lrn_across_channels(float* output, const float* input, const int channels, const int size,
+                         const int local_size, const float alpha, const float beta, const float k, const int num_threads)
+{
+    const int pre = (local_size - 1) / 2;
+    const float scale = alpha / local_size;
+    //Positions per block, the running sums stay in registers and L1.
+    const int block = 64;
+    const int blocks = (size + block - 1) / block;
+    #pragma omp parallel for num_threads(num_threads) schedule(static)
+    for (int b = 0; b < blocks; ++b)
+    {
+        const int p = b * block;
+        const int len = (size - p < block) ? size - p : block;
+        float sum[block];
+        memset(sum, 0, sizeof(float) * len);
+        for (int m = 0; m <= pre && m < channels; ++m)
+            accumulate_squares<true>(sum, input + m * size + p, len);
+        for (int c = 0; c < channels; ++c)
+        {
+            lrn_apply(output + c * size + p, input + c * size + p, sum, len, k, scale, beta);
+            //Slide the window to channel c + 1.
+            if (c + pre + 1 < channels)
+                accumulate_squares<true>(sum, input + (c + pre + 1) * size + p, len);
+            if (c - pre >= 0)
+                accumulate_squares<false>(sum, input + (c - pre) * size + p, len);
+        }
+    }
+}
+
+//Rows processed by one task of lrn_within_channel.
+static const int kWithinBandRows = 16;
+
+static int per_thread_floats(const int width, const int local_size)
+{
+    //Zero padded squares, their row sums and the running sum over rows.
+    return (width + local_size) + width + width;
+}
+
+int lrn_within_channel_buffer_size(const int width, const int local_size, const int num_threads)
+{
+    return per_thread_floats(width, local_size) * num_threads;
+}
+
+//Horizontal window sums of the squares of one row. padded has zeros in its first and last pre entries.
+static void square_row_sums(float* row_sum, float* padded, const float* row, const int width, const int local_size)
+{
+    const int pre = (local_size - 1) / 2;
+    float* sq = padded + pre;
+    int x = 0;
+    for (; x + 4 <= width; x += 4)
+    {
+        float32x4_t v = vld1q_f32(row + x);
+        vst1q_f32(sq + x, vmulq_f32(v, v));
+    }
+    for (; x < width; ++x)
+        sq[x] = row[x] * row[x];
+    x = 0;
+    for (; x + 4 <= width; x += 4)
+    {
+        float32x4_t s = vld1q_f32(padded + x);
+        for (int d = 1; d < local_size; ++d)
+            s = vaddq_f32(s, vld1q_f32(padded + x + d));
+        vst1q_f32(row_sum + x, s);
+    }
+    for (; x < width; ++x)
+    {
+        float s = 0.f;
+        for (int d = 0; d < local_size; ++d)
+            s += padded[x + d];
+        row_sum[x] = s;
+    }
+}
+
+void lrn_within_channel(float* output, const float* input, const int channels, const int height, const int width,
+                        const int local_size, const float alpha, const float beta, float* buffer, const int num_threads)
+{
+    const int pre = (local_size - 1) / 2;
+    const float scale = alpha / (local_size * local_size);
+    const int bands = (height + kWithinBandRows - 1) / kWithinBandRows;
+    const int stride = per_thread_floats(width, local_size);
+    #pragma omp parallel for num_threads(num_threads) schedule(static) collapse(2)
+    for (int c = 0; c < channels; ++c)
+    {
+        for (int b = 0; b < bands; ++b)
+        {
+            int tid = 0;
+#ifdef _OPENMP
+            tid = omp_get_thread_num();
+#endif
+            float* padded = buffer + tid * stride;
+            float* row_sum = padded + width + local_size;
+            float* col_sum = row_sum + width;
+            memset(padded, 0, sizeof(float) * (width + local_size));
+            memset(col_sum, 0, sizeof(float) * width);
+
+            const float* in_c = input + c * height * width;
+            float* out_c = output + c * height * width;
+            const int row_begin = b * kWithinBandRows;
+            const int row_end = (row_begin + kWithinBandRows < height) ? row_begin + kWithinBandRows : height;
+            //Window of the first row in the band.
+            for (int y = row_begin - pre; y <= row_begin + pre; ++y)
+            {
+                if (y < 0 || y >= height)
+                    continue;
+                square_row_sums(row_sum, padded, in_c + y * width, width, local_size);
+                accumulate_rows<true>(col_sum, row_sum, width);
+            }
+            for (int y = row_begin; y < row_end; ++y)
+            {
+                lrn_apply(out_c + y * width, in_c + y * width, col_sum, width, 1.f, scale, beta);
+                if (y + 1 == row_end)
+                    break;
+                if (y + pre + 1 < height)
+                {
+                    square_row_sums(row_sum, padded, in_c + (y + pre + 1) * width, width, local_size);
+                    accumulate_rows<true>(col_sum, row_sum, width);
+                }
+                if (y - pre >= 0)
+                {
+                    square_row_sums(row_sum, padded, in_c + (y - pre) * width, width, local_size);
+                    accumulate_rows<false>(col_sum, row_sum, width);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,34 @@
+//Tencent is pleased to support the open source community by making FeatherCNN available.
+
+//Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+
+//Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+//in compliance with the License. You may obtain a copy of the License at
+//
+//https://opensource.org/licenses/BSD-3-Clause
+//
+//Unless required by applicable law or agreed to in writing, software distributed
+//under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//CONDITIONS OF ANY KIND, either express or implied. See the License for the
+//specific language governing permissions and limitations under the License.
+
+#pragma once
+
+/*
+ * Caffe's ACROSS_CHANNELS LRN: output = input * (k + alpha / local_size * sum of squares over
+ * local_size neighbouring channels) ^ -beta. The channel window slides over blocks of spatial
+ * positions, threads split the positions.
+ */
+void lrn_across_channels(float* output, const float* input, const int channels, const int size,
+                         const int local_size, const float alpha, const float beta, const float k, const int num_threads);
+
+/*
+ * Caffe's WITHIN_CHANNEL LRN: output = input * (1 + alpha / local_size^2 * sum of squares over the
+ * zero padded local_size x local_size window) ^ -beta. The window sum is a separable box filter:
+ * row sums of the squares, then a running sum over rows. Threads split channels and row bands.
+ * buffer: lrn_within_channel_buffer_size floats.
+ */
+void lrn_within_channel(float* output, const float* input, const int channels, const int height, const int width,
+                        const int local_size, const float alpha, const float beta, float* buffer, const int num_threads);
+
+int lrn_within_channel_buffer_size(const int width, const int local_size, const int num_threads);
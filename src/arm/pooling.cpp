@@ -0,0 +1,277 @@
+//Tencent is pleased to support the open source community by making FeatherCNN available.
+
+//Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+
+//Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+//in compliance with the License. You may obtain a copy of the License at
+//
+//https://opensource.org/licenses/BSD-3-Clause
+//
+//Unless required by applicable law or agreed to in writing, software distributed
+//under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//CONDITIONS OF ANY KIND, either express or implied. See the License for the
+//specific language governing permissions and limitations under the License.
+
+#include "pooling.h"
+
+#include <float.h>
+#include <arm_neon.h>
+
+#ifdef __APPLE__
+#else
+#include <omp.h>
+#endif
+
+template<bool is_max>
+static inline float32x4_t pool_op(float32x4_t a, float32x4_t b)
+{
+    return is_max ? vmaxq_f32(a, b) : vaddq_f32(a, b);
+}
+
+//One output of a window clipped to the input, rows are relative to the band.
+template<bool is_max>
+static inline float pool_window(const float* in_c, const int input_w, const int band_begin,
+                                const int h_min, const int h_max, int w_min, int w_max)
+{
+    w_min = (w_min < 0) ? 0 : w_min;
+    w_max = (w_max > input_w) ? input_w : w_max;
+    if (h_max <= h_min || w_max <= w_min)
+        return 0.f;
+    float total = is_max ? -FLT_MAX : 0.f;
+    for (int h = h_min; h < h_max; ++h)
+    {
+        const float* in_p = in_c + (h - band_begin) * input_w;
+        for (int w = w_min; w < w_max; ++w)
+        {
+            if (is_max)
+                total = (total > in_p[w]) ? total : in_p[w];
+            else
+                total += in_p[w];
+        }
+    }
+    return is_max ? total : total / ((h_max - h_min) * (w_max - w_min));
+}
+
+/*
+ * Four outputs of a K x K stride S window from rows r[0..K), the first one starting at column x.
+ * 2x2s2 and 3x3s2 deinterleave the columns with vld2q, 3x3s1 reads three shifted vectors.
+ */
+template<bool is_max, int K, int S>
+static inline float32x4_t pool_interior4(const float* const* r, const int x)
+{
+    float32x4_t total;
+    for (int k = 0; k < K; ++k)
+    {
+        float32x4_t v;
+        if (S == 2)
+        {
+            float32x4x2_t p = vld2q_f32(r[k] + x);
+            v = pool_op<is_max>(p.val[0], p.val[1]);
+            if (K == 3)
+                v = pool_op<is_max>(v, vld2q_f32(r[k] + x + 2).val[0]);
+        }
+        else
+        {
+            v = pool_op<is_max>(vld1q_f32(r[k] + x), vld1q_f32(r[k] + x + 1));
+            v = pool_op<is_max>(v, vld1q_f32(r[k] + x + 2));
+        }
+        total = (k == 0) ? v : pool_op<is_max>(total, v);
+    }
+    return is_max ? total : vmulq_n_f32(total, 1.f / (K * K));
+}
+
+/*
+ * Windows fixed at compile time. Output rows whose window lies inside the input run the vector
+ * kernel over the columns that need no clipping, border rows and columns take the clipped path.
+ */
+template<bool is_max, int K, int S>
+static void pooling_rows_fixed(float* output, const float* input, const int channels,
+                               const int input_h, const int input_w, const int band_begin, const int band_rows,
+                               const int output_h, const int output_w, const int row_begin, const int row_end,
+                               const int pad_h, const int pad_w, const int num_threads)
+{
+    const int rows = row_end - row_begin;
+    //Interior columns [j_begin, j_end) have their window inside the input.
+    const int j_begin = (pad_w + S - 1) / S;
+    int j_end = (input_w - K + pad_w >= 0) ? (input_w - K + pad_w) / S + 1 : 0;
+    j_end = (j_end > output_w) ? output_w : j_end;
+    //Last column loaded by pool_interior4, relative to the first window. 3x3s2 loads one past its windows.
+    const int read_span = (S == 1) ? 5 : ((K == 2) ? 7 : 9);
+    #pragma omp parallel for num_threads(num_threads) schedule(static) collapse(2)
+    for (int c = 0; c < channels; ++c)
+    {
+        for (int r = 0; r < rows; ++r)
+        {
+            const int i = row_begin + r;
+            const float* in_c = input + c * band_rows * input_w;
+            float* out_p = output + (c * output_h + i) * output_w;
+            const int h_start = i * S - pad_h;
+            const int h_min = (h_start < 0) ? 0 : h_start;
+            const int h_max = (h_start + K > input_h) ? input_h : h_start + K;
+            int j = 0;
+            if (h_start >= 0 && h_start + K <= input_h && j_begin < j_end)
+            {
+                const float* rp[K];
+                for (int k = 0; k < K; ++k)
+                    rp[k] = in_c + (h_start + k - band_begin) * input_w;
+                for (; j < j_begin; ++j)
+                    out_p[j] = pool_window<is_max>(in_c, input_w, band_begin, h_min, h_max, j * S - pad_w, j * S - pad_w + K);
+                for (; j + 4 <= j_end && j * S - pad_w + read_span < input_w; j += 4)
+                    vst1q_f32(out_p + j, pool_interior4<is_max, K, S>(rp, j * S - pad_w));
+            }
+            for (; j < output_w; ++j)
+                out_p[j] = pool_window<is_max>(in_c, input_w, band_begin, h_min, h_max, j * S - pad_w, j * S - pad_w + K);
+        }
+    }
+}
+
+template<bool is_max>
+static void pooling_rows_inner(float* output, const float* input, const int channels,
+                               const int input_h, const int input_w, const int band_begin, const int band_rows,
+                               const int output_h, const int output_w, const int row_begin, const int row_end,
+                               const int kernel_h, const int kernel_w, const int stride_h, const int stride_w,
+                               const int pad_h, const int pad_w, const int num_threads)
+{
+    const int rows = row_end - row_begin;
+    #pragma omp parallel for num_threads(num_threads) schedule(static) collapse(2)
+    for (int c = 0; c < channels; ++c)
+    {
+        for (int r = 0; r < rows; ++r)
+        {
+            const int i = row_begin + r;
+            const float* in_c = input + c * band_rows * input_w;
+            float* out_p = output + (c * output_h + i) * output_w;
+            int h_min = i * stride_h - pad_h;
+            int h_max = h_min + kernel_h;
+            h_min = (h_min < 0) ? 0 : h_min;
+            h_max = (h_max > input_h) ? input_h : h_max;
+            for (int j = 0; j < output_w; ++j)
+                out_p[j] = pool_window<is_max>(in_c, input_w, band_begin, h_min, h_max, j * stride_w - pad_w, j * stride_w - pad_w + kernel_w);
+        }
+    }
+}
+
+//Whole-map window: one reduction per channel, four lanes at a time.
+template<bool is_max>
+static void pooling_global(float* output, const float* input, const int channels, const int size, const int num_threads)
+{
+    #pragma omp parallel for num_threads(num_threads) schedule(static)
+    for (int c = 0; c < channels; ++c)
+    {
+        const float* in_p = input + c * size;
+        float32x4_t acc = vdupq_n_f32(is_max ? -FLT_MAX : 0.f);
+        int i = 0;
+        for (; i + 4 <= size; i += 4)
+            acc = pool_op<is_max>(acc, vld1q_f32(in_p + i));
+        float32x2_t half = is_max ? vmax_f32(vget_low_f32(acc), vget_high_f32(acc)) : vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+        half = is_max ? vpmax_f32(half, half) : vpadd_f32(half, half);
+        float total = vget_lane_f32(half, 0);
+        for (; i < size; ++i)
+        {
+            if (is_max)
+                total = (total > in_p[i]) ? total : in_p[i];
+            else
+                total += in_p[i];
+        }
+        output[c] = is_max ? total : total / size;
+    }
+}
+
+template<bool is_max>
+static void pooling_rows_dispatch(float* output, const float* input, const int channels,
+                                  const int input_h, const int input_w, const int band_begin, const int band_rows,
+                                  const int output_h, const int output_w, const int row_begin, const int row_end,
+                                  const int kernel_h, const int kernel_w, const int stride_h, const int stride_w,
+                                  const int pad_h, const int pad_w, const int num_threads)
+{
+    const bool whole_map = (band_begin == 0 && band_rows == input_h && output_h == 1 && output_w == 1
+                            && kernel_h == input_h && kernel_w == input_w && pad_h == 0 && pad_w == 0);
+    const bool square = (kernel_h == kernel_w && stride_h == stride_w);
+    if (whole_map)
+        pooling_global<is_max>(output, input, channels, input_h * input_w, num_threads);
+    else if (square && kernel_h == 2 && stride_h == 2)
+        pooling_rows_fixed<is_max, 2, 2>(output, input, channels, input_h, input_w, band_begin, band_rows,
+                                         output_h, output_w, row_begin, row_end, pad_h, pad_w, num_threads);
+    else if (square && kernel_h == 3 && stride_h == 2)
+        pooling_rows_fixed<is_max, 3, 2>(output, input, channels, input_h, input_w, band_begin, band_rows,
+                                         output_h, output_w, row_begin, row_end, pad_h, pad_w, num_threads);
+    else if (square && kernel_h == 3 && stride_h == 1)
+        pooling_rows_fixed<is_max, 3, 1>(output, input, channels, input_h, input_w, band_begin, band_rows,
+                                         output_h, output_w, row_begin, row_end, pad_h, pad_w, num_threads);
+    else
+        pooling_rows_inner<is_max>(output, input, channels, input_h, input_w, band_begin, band_rows, output_h, output_w,
+                                   row_begin, row_end, kernel_h, kernel_w, stride_h, stride_w, pad_h, pad_w, num_threads);
+}
+
+void pooling_rows(float* output, const float* input, const bool is_max, const int channels,
+                  const int input_h, const int input_w, const int band_begin, const int band_rows,
+                  const int output_h, const int output_w, const int row_begin, const int row_end,
+                  const int kernel_h, const int kernel_w, const int stride_h, const int stride_w,
+                  const int pad_h, const int pad_w, const int num_threads)
+{
+    if (is_max)
+        pooling_rows_dispatch<true>(output, input, channels, input_h, input_w, band_begin, band_rows, output_h, output_w,
+                                    row_begin, row_end, kernel_h, kernel_w, stride_h, stride_w, pad_h, pad_w, num_threads);
+    else
+        pooling_rows_dispatch<false>(output, input, channels, input_h, input_w, band_begin, band_rows, output_h, output_w,
+                                     row_begin, row_end, kernel_h, kernel_w, stride_h, stride_w, pad_h, pad_w, num_threads);
+}
+
+template<bool is_max>
+static void pooling_nc4hw4_inner(float* output, const float* input, const int channels,
+                                 const int input_h, const int input_w, const int output_h, const int output_w,
+                                 const int kernel_h, const int kernel_w, const int stride_h, const int stride_w,
+                                 const int pad_h, const int pad_w, const int num_threads)
+{
+    const int blocks = (channels + 3) / 4;
+    #pragma omp parallel for num_threads(num_threads) schedule(static) collapse(2)
+    for (int b = 0; b < blocks; ++b)
+    {
+        for (int i = 0; i < output_h; ++i)
+        {
+            const float* in_b = input + b * input_h * input_w * 4;
+            float* out_p = output + (b * output_h + i) * output_w * 4;
+            int h_min = i * stride_h - pad_h;
+            int h_max = h_min + kernel_h;
+            h_min = (h_min < 0) ? 0 : h_min;
+            h_max = (h_max > input_h) ? input_h : h_max;
+            for (int j = 0; j < output_w; ++j)
+            {
+                int w_min = j * stride_w - pad_w;
+                int w_max = w_min + kernel_w;
+                w_min = (w_min < 0) ? 0 : w_min;
+                w_max = (w_max > input_w) ? input_w : w_max;
+                float32x4_t total = vdupq_n_f32(is_max ? -FLT_MAX : 0.f);
+                for (int h = h_min; h < h_max; ++h)
+                {
+                    const float* in_p = in_b + h * input_w * 4;
+                    for (int w = w_min; w < w_max; ++w)
+                    {
+                        if (is_max)
+                            total = vmaxq_f32(total, vld1q_f32(in_p + w * 4));
+                        else
+                            total = vaddq_f32(total, vld1q_f32(in_p + w * 4));
+                    }
+                }
+                if (h_max <= h_min || w_max <= w_min)
+                    total = vdupq_n_f32(0.f);
+                else if (!is_max)
+                    total = vmulq_n_f32(total, 1.f / ((h_max - h_min) * (w_max - w_min)));
+                vst1q_f32(out_p + j * 4, total);
+            }
+        }
+    }
+}
+
+void pooling_nc4hw4(float* output, const float* input, const bool is_max, const int channels,
+                    const int input_h, const int input_w, const int output_h, const int output_w,
+                    const int kernel_h, const int kernel_w, const int stride_h, const int stride_w,
+                    const int pad_h, const int pad_w, const int num_threads)
+{
+    if (is_max)
+        pooling_nc4hw4_inner<true>(output, input, channels, input_h, input_w, output_h, output_w,
+                                   kernel_h, kernel_w, stride_h, stride_w, pad_h, pad_w, num_threads);
+    else
+        pooling_nc4hw4_inner<false>(output, input, channels, input_h, input_w, output_h, output_w,
+                                    kernel_h, kernel_w, stride_h, stride_w, pad_h, pad_w, num_threads);
+}
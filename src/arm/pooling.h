@@ -0,0 +1,35 @@
+//Tencent is pleased to support the open source community by making FeatherCNN available.
+
+//Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+
+//Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+//in compliance with the License. You may obtain a copy of the License at
+//
+//https://opensource.org/licenses/BSD-3-Clause
+//
+//Unless required by applicable law or agreed to in writing, software distributed
+//under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//CONDITIONS OF ANY KIND, either express or implied. See the License for the
+//specific language governing permissions and limitations under the License.
+
+#pragma once
+
+#include <stdio.h>
+
+/*
+ * Pools rows [row_begin, row_end) of an output_h x output_w map from an input_h x input_w map.
+ * The input holds only rows [band_begin, band_begin + band_rows) of every channel, which lets
+ * a producer layer feed the pooling band by band. Windows are clipped to the input, average
+ * pooling divides by the number of clipped elements.
+ */
+void pooling_rows(float* output, const float* input, const bool is_max, const int channels,
+                  const int input_h, const int input_w, const int band_begin, const int band_rows,
+                  const int output_h, const int output_w, const int row_begin, const int row_end,
+                  const int kernel_h, const int kernel_w, const int stride_h, const int stride_w,
+                  const int pad_h, const int pad_w, const int num_threads);
+
+//Same windows as pooling_rows on NC4HW4 data, four channels per vector.
+void pooling_nc4hw4(float* output, const float* input, const bool is_max, const int channels,
+                    const int input_h, const int input_w, const int output_h, const int output_w,
+                    const int kernel_h, const int kernel_w, const int stride_h, const int stride_w,
+                    const int pad_h, const int pad_w, const int num_threads);
@@ -829,7 +829,7 @@ InnerKernel get_kernel_Nx12(int k)
 }
 
 template<bool fuseBias, bool fuseRelu>
-inline void compute_block_activation(int M, int nc, int kc, float* packA, float* packB, float* loadC, float *C, int ldc, float* bias, int bias_len, InnerKernel inner_kernel_local)
+inline void compute_block_activation(int M, int nc, int kc, float* packA, float* packB, float* loadC, float *C, int ldc, float* bias, int bias_len, InnerKernel inner_kernel_local, bool accumulate)
 {
 #ifdef SQUARE_TILE
 	const int COL_BATCH = 8;
@@ -843,12 +843,17 @@ inline void compute_block_activation(int M, int nc, int kc, float* packA, float*
 	const int nc_floor = nc - nc % 8;
 	for(int i = 0; i < M - M % ROW_BATCH; i += ROW_BATCH)
 	{
-		//Load C into cache
+		//Load C into cache, the first K block starts from zero instead.
 		float* rC = C + i * ldc;
 		for(int m = 0; m < ROW_BATCH; ++m)
 		{
 			float* pC = rC + m * ldc;
 			float* pL = loadC + m * nc_ceil;
+			if(!accumulate)
+			{
+				memset(pL, 0, sizeof(float) * nc_ceil);
+				continue;
+			}
 			for(int n = 0; n < nc_floor; n += 8)
 			{
 				vst1q_f32(pL + n, vld1q_f32(pC + n));
@@ -921,20 +926,28 @@ inline void compute_block_activation(int M, int nc, int kc, float* packA, float*
 	if(m_len)
 	{
 		int i = M - M % ROW_BATCH;
-		//Load C into cache
+		//Load C into cache, the first K block starts from zero instead.
 		float* rC = C + i * ldc;
 		for(int m = 0; m < m_len; ++m)
 		{
 			float* pC = rC + m * ldc;
 			float* pL = loadC + m * nc_ceil;
+			if(!accumulate)
+			{
+				memset(pL, 0, sizeof(float) * nc_ceil);
+				continue;
+			}
 			for(int n = 0; n < nc_floor; n += 8)
 			{
 				vst1q_f32(pL + n, vld1q_f32(pC + n));
 				vst1q_f32(pL + n + 4, vld1q_f32(pC + n + 4));
 			}
-			for(int n = nc - nc % 8; n < nc; ++n)
+			for(int n = nc - nc % 8; n < nc_ceil; ++n)
 			{
-				pL[n] = pC[n];
+				if(n < nc)
+					pL[n] = pC[n];
+				else
+					pL[n] = 0.f;
 			}
 		}
 		for(int j = 0; j < nc_ceil; j+=COL_BATCH)
@@ -1027,40 +1040,65 @@ void packed_sgemm_init(int M, int K, int kc, float* packA, float* A, int lda)
 template void packed_sgemm_init<8>(int M, int K, int kc, float* packedA, float* A, int lda);
 template void packed_sgemm_init<4>(int M, int K, int kc, float* packedA, float* A, int lda);
 
+//Packs a kc x nc block of B into COL_BATCH wide panels, the last panel is padded with zeros.
+template<int COL_BATCH>
 void pack_B_neon(int kc, int nc, float* packB, float* B, int ldb)
 {
-	//const int COL_BATCH = 16;
-	const int COL_BATCH = 8;
 	int nc_floor = nc - nc % COL_BATCH;
+	int step = COL_BATCH * kc;
 	for(int k = 0; k < kc; ++k)
 	{
 		float* pB = B + k * ldb;
-
-		float* pPack = packB + k*COL_BATCH;
-		int    step = COL_BATCH*kc;
+		float* pPack = packB + k * COL_BATCH;
 		for(int j = 0; j < nc_floor; j += COL_BATCH)
 		{
-//			float* pPack = packB + (j / COL_BATCH) * kc * COL_BATCH + k * COL_BATCH;
-			vst1q_f32(pPack,     vld1q_f32(pB));
-			vst1q_f32(pPack + 4, vld1q_f32(pB + 4));
-			pB += 8;
+			for(int c = 0; c < COL_BATCH; c += 4)
+				vst1q_f32(pPack + c, vld1q_f32(pB + c));
+			pB += COL_BATCH;
 			pPack += step;
 		}
 		if(nc_floor < nc)
 		{
-			int j = nc_floor;
 			int n_len = nc - nc_floor;
-			float* pPack = packB + j  * kc  + k*COL_BATCH;
 			for(int i = 0; i < n_len; ++i)
-			{
 				pPack[i] = pB[i];
-			}
+			for(int i = n_len; i < COL_BATCH; ++i)
+				pPack[i] = 0.f;
+		}
+	}
+}
+
+//Packs a kc x nc block of B gathered from an image: column n is pixel (n / out_width, n % out_width) of
+//the output grid, sampled every stride pixels of an in_width wide input. Rows of B are ldb apart.
+template<int COL_BATCH>
+void pack_B_strided(int kc, int nc, float* packB, float* B, int ldb, int n_begin, int out_width, int in_width, int stride)
+{
+	int offsets[COL_BATCH];
+	for(int j = 0; j < nc; j += COL_BATCH)
+	{
+		int n_len = (nc - j < COL_BATCH) ? nc - j : COL_BATCH;
+		for(int i = 0; i < n_len; ++i)
+		{
+			int n = n_begin + j + i;
+			offsets[i] = (n / out_width) * stride * in_width + (n % out_width) * stride;
+		}
+		float* pPack = packB + j * kc;
+		for(int k = 0; k < kc; ++k)
+		{
+			float* pB = B + k * ldb;
+			for(int i = 0; i < n_len; ++i)
+				pPack[i] = pB[offsets[i]];
+			for(int i = n_len; i < COL_BATCH; ++i)
+				pPack[i] = 0.f;
+			pPack += COL_BATCH;
 		}
 	}
 }
-	
+
+//N is split in column blocks of at most nc, each thread packs its own block of B.
+//out_width == 0 reads B as a dense matrix, otherwise through pack_B_strided.
 template<bool fuseBias, bool fuseRelu>
-void packed_sgemm_activation(int M, int N, int K, float *packA, float *b, int ldb, float *c, int ldc, int nc, int kc, float* bias, int num_threads, float* pack_array)
+static void packed_sgemm_blocks(int M, int N, int K, float *packA, float *b, int ldb, int out_width, int in_width, int stride, float *c, int ldc, int nc, int kc, float* bias, int num_threads, float* pack_array)
 {
 #ifdef SQUARE_TILE
 	const int ROW_BATCH = 8;
@@ -1071,85 +1109,60 @@ void packed_sgemm_activation(int M, int N, int K, float *packA, float *b, int ld
 	const int COL_BATCH = 12;
 	InnerKernel inner_kernel_local = get_kernel_Nx12(M % ROW_BATCH);
 #endif
-	
-	for(int i = 0; i < M; ++i){
-		memset(c + ldc * i, 0, sizeof(float) * N);
-	}
+	const int thread_stride = (kc + 8) * nc;
+	//Column blocks are whole panels, and small enough to keep every thread busy.
+	int block_n = align_ceil((N + num_threads - 1) / num_threads, COL_BATCH);
+	block_n = (block_n < nc) ? block_n : nc - nc % COL_BATCH;
 
-	int M_align = align_ceil(M, ROW_BATCH);
-	int N_align = align_ceil(N, COL_BATCH);
-
-	int NBlocks = (N_align + nc - 1) / nc;
+	int NBlocks = (N + block_n - 1) / block_n;
 	int KBlocks = (K + kc - 1) / kc;
 
-	//printf("Nblocks %d K blocks %d\n", NBlocks, KBlocks);
-	
-	//float *packB = (float*) malloc(kc * nc * sizeof(float));
 	//Our GEMM is implemented in GEPB fashion, as the operands are row-major
-	float* packB = pack_array;
-	float* loadC = pack_array + kc * nc;
-	int k_len = kc;
-	int n_len = nc;
-	for(int kt = 0; kt < KBlocks - 1; ++kt)
+	for(int kt = 0; kt < KBlocks; ++kt)
 	{
-		//k_len = (kt == KBlocks - 1) ? (K - kt * kc) : kc;
-#ifdef __aarch64__
+		const int k_len = (kt == KBlocks - 1) ? (K - kt * kc) : kc;
+		const bool last = (kt == KBlocks - 1);
+		float* pA = packA + kt * kc * M;
 #pragma omp parallel for num_threads(num_threads) schedule(static)
-#endif
-      	for(int nt = 0; nt < NBlocks; ++nt)
-      	{
+		for(int nt = 0; nt < NBlocks; ++nt)
+		{
+			int tid = 0;
 #ifdef _OPENMP
-			int tid = omp_get_thread_num();
-			packB = pack_array + tid * (kc + 8) * nc;
-			loadC = packB + kc * nc;
+			tid = omp_get_thread_num();
 #endif
-			//float loadC[ROW_BATCH * nc];
-			//float packB[kc * nc];
-			//float* pA = packA + kt * kc * M_align;
-			float* pA = packA + kt * kc * M;
-			float* pB = b + kt * kc * ldb + nt * nc;
-			float* pC = c + nt * nc; 
-			if(nt == NBlocks - 1)
-				n_len = N - nt * nc;
+			float* packB = pack_array + tid * thread_stride;
+			float* loadC = packB + kc * nc;
+			float* pC = c + nt * block_n;
+			int n_len = (nt == NBlocks - 1) ? (N - nt * block_n) : block_n;
+			if(out_width == 0)
+				pack_B_neon<COL_BATCH>(k_len, n_len, packB, b + kt * kc * ldb + nt * block_n, ldb);
 			else
-				n_len = nc;
-			//I'm going to pack B in here.
-//			memset(packB, 0, sizeof(float) * kc * nc);
-			pack_B_neon(k_len, n_len, packB, pB, N);
-			compute_block_activation<false, false>(M, n_len, k_len, pA, packB, loadC, pC, ldc, bias, M, inner_kernel_local);
-		}
-	}
-	{
-		int kt = KBlocks - 1;
-		k_len = (K - kt * kc);
-#ifdef __aarch64__
-#pragma omp parallel for num_threads(num_threads) schedule(static)
-#endif
-      	for(int nt = 0; nt < NBlocks; ++nt)
-      	{
-#ifdef _OPENMP
-			int tid = omp_get_thread_num();
-			packB = pack_array + tid * (kc + 8) * nc;
-			loadC = packB + kc * nc;
-#endif
-			//float loadC[ROW_BATCH * nc];
-			//float packB[kc * nc];
-			float* pA = packA + kt * kc * M;
-			float* pB = b + kt * kc * ldb + nt * nc;
-			float* pC = c + nt * nc; 
-			if(nt == NBlocks - 1)
-				n_len = N - nt * nc;
+				pack_B_strided<COL_BATCH>(k_len, n_len, packB, b + kt * kc * ldb, ldb, nt * block_n, out_width, in_width, stride);
+			if(last)
+				compute_block_activation<fuseBias, fuseRelu>(M, n_len, k_len, pA, packB, loadC, pC, ldc, bias, M, inner_kernel_local, kt > 0);
 			else
-				n_len = nc;
-//			memset(packB, 0, sizeof(float) * kc * nc);
-
-			pack_B_neon(k_len, n_len, packB, pB, N);
-			compute_block_activation<fuseBias, fuseRelu>(M, n_len, k_len, pA, packB, loadC, pC, ldc, bias, M, inner_kernel_local);
+				compute_block_activation<false, false>(M, n_len, k_len, pA, packB, loadC, pC, ldc, bias, M, inner_kernel_local, kt > 0);
 		}
 	}
 }
 
+template<bool fuseBias, bool fuseRelu>
+void packed_sgemm_activation(int M, int N, int K, float *packA, float *b, int ldb, float *c, int ldc, int nc, int kc, float* bias, int num_threads, float* pack_array)
+{
+	packed_sgemm_blocks<fuseBias, fuseRelu>(M, N, K, packA, b, ldb, 0, 0, 1, c, ldc, nc, kc, bias, num_threads, pack_array);
+}
+
+template<bool fuseBias, bool fuseRelu>
+void packed_sgemm_strided_activation(int M, int N, int K, float *packA, float *b, int ldb, int out_width, int in_width, int stride, float *c, int ldc, int nc, int kc, float* bias, int num_threads, float* pack_array)
+{
+	packed_sgemm_blocks<fuseBias, fuseRelu>(M, N, K, packA, b, ldb, out_width, in_width, stride, c, ldc, nc, kc, bias, num_threads, pack_array);
+}
+
 template void packed_sgemm_activation<false, false>(int, int, int, float *, float *, int, float *, int , int , int , float* , int, float*);
 template void packed_sgemm_activation<false,  true>(int, int, int, float *, float *, int, float *, int , int , int , float* , int, float*);
 template void packed_sgemm_activation<true,  false>(int, int, int, float *, float *, int, float *, int , int , int , float* , int, float*);
 template void packed_sgemm_activation<true,   true>(int, int, int, float *, float *, int, float *, int , int , int , float* , int, float*);
+template void packed_sgemm_strided_activation<false, false>(int, int, int, float *, float *, int, int, int, int, float *, int , int , int , float* , int, float*);
+template void packed_sgemm_strided_activation<false,  true>(int, int, int, float *, float *, int, int, int, int, float *, int , int , int , float* , int, float*);
+template void packed_sgemm_strided_activation<true,  false>(int, int, int, float *, float *, int, int, int, int, float *, int , int , int , float* , int, float*);
+template void packed_sgemm_strided_activation<true,   true>(int, int, int, float *, float *, int, int, int, int, float *, int , int , int , float* , int, float*);
@@ -12,5 +12,16 @@ template<int ROW_BATCH>
 void packed_sgemm_init(int M, int K, int kc, float* packA, float* A, int lda);
 
 //void packed_sgemm(int M, int N, int K, float *packA, float *B, int ldb, float *C, int ldc, int nc, int kc);
+/*
+ * A is packed by packed_sgemm_init<4> with the same kc. Bias (per row of C) and ReLU are applied
+ * as C is written back. pack_array: (kc + 8) * nc * num_threads floats, nc >= 12.
+ */
 template<bool fuseBias, bool fuseRelu>
 void packed_sgemm_activation(int M, int N, int K, float *packA, float *b, int ldb, float *c, int ldc, int nc, int kc, float* bias, int num_threads, float* pack_array);
+
+/*
+ * Same as packed_sgemm_activation with B gathered from a CHW image, as for 1x1 convolutions
+ * without padding: column n of row k is b[k * ldb + (n / out_width) * stride * in_width + (n % out_width) * stride].
+ */
+template<bool fuseBias, bool fuseRelu>
+void packed_sgemm_strided_activation(int M, int N, int K, float *packA, float *b, int ldb, int out_width, int in_width, int stride, float *c, int ldc, int nc, int kc, float* bias, int num_threads, float* pack_array);
@@ -15,6 +15,7 @@
 #include "sgemv.h"
 
 #include <assert.h>
+#include <math.h>
 #include <arm_neon.h>
 #include <string.h>
 
@@ -210,3 +211,79 @@ void matrixTranspose(float* array, size_t m, size_t n, float *buffer)//  A[m][n]
             buffer[j * m + i] = array[i * n + j];
     memcpy(array, buffer, m * n * sizeof(float));
 }
+
+void quantize_rows_int8(int8_t *q, float *scales, const float *w, const int rows, const int cols)
+{
+    for (int i = 0; i < rows; i++)
+    {
+        const float *row = w + (size_t) i * cols;
+        float max = 0.f;
+        for (int j = 0; j < cols; j++)
+            max = (fabsf(row[j]) > max) ? fabsf(row[j]) : max;
+        const float inv = (max > 0.f) ? 127.f / max : 0.f;
+        for (int j = 0; j < cols; j++)
+            q[(size_t) i * cols + j] = (int8_t) lroundf(row[j] * inv);
+        scales[i] = max / 127.f;
+    }
+}
+
+static inline float horizontal_sum(float32x4_t v)
+{
+    float32x2_t s = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+    return vget_lane_f32(vpadd_f32(s, s), 0);
+}
+
+//Eight int8 weights widened to fp32 and multiplied with eight activations.
+static inline void dot8_int8(float32x4_t &acc0, float32x4_t &acc1, const int8_t *w, const float32x4_t x0, const float32x4_t x1)
+{
+    int16x8_t w16 = vmovl_s8(vld1_s8(w));
+    acc0 = vmlaq_f32(acc0, vcvtq_f32_s32(vmovl_s16(vget_low_s16(w16))), x0);
+    acc1 = vmlaq_f32(acc1, vcvtq_f32_s32(vmovl_s16(vget_high_s16(w16))), x1);
+}
+
+template<bool fuseBias, bool fuseRelu>
+void fully_connected_inference_int8(const int input_size, const int output_size, const float *x, const int8_t *y, const float *scales, float *z, const float *bias, const int num_threads)
+{
+    const int groups = (output_size + 3) / 4;
+    //Four rows share every load of x.
+    #pragma omp parallel for schedule(static) num_threads(num_threads)
+    for (int g = 0; g < groups; g++)
+    {
+        const int rows = (output_size - 4 * g < 4) ? output_size - 4 * g : 4;
+        //The last group repeats its last row instead of branching in the inner loop.
+        const int8_t *w[4];
+        for (int r = 0; r < 4; r++)
+            w[r] = y + (size_t)(4 * g + ((r < rows) ? r : rows - 1)) * input_size;
+        float32x4_t acc[4][2];
+        for (int r = 0; r < 4; r++)
+        {
+            acc[r][0] = vdupq_n_f32(0.f);
+            acc[r][1] = vdupq_n_f32(0.f);
+        }
+        int j = 0;
+        for (; j + 8 <= input_size; j += 8)
+        {
+            const float32x4_t x0 = vld1q_f32(x + j);
+            const float32x4_t x1 = vld1q_f32(x + j + 4);
+            for (int r = 0; r < 4; r++)
+                dot8_int8(acc[r][0], acc[r][1], w[r] + j, x0, x1);
+        }
+        for (int r = 0; r < rows; r++)
+        {
+            float sum = horizontal_sum(vaddq_f32(acc[r][0], acc[r][1]));
+            for (int k = j; k < input_size; k++)
+                sum += w[r][k] * x[k];
+            sum *= scales[4 * g + r];
+            if (fuseBias)
+                sum += bias[4 * g + r];
+            if (fuseRelu)
+                sum = (sum > 0.f) ? sum : 0.f;
+            z[4 * g + r] = sum;
+        }
+    }
+}
+
+template void fully_connected_inference_int8<false, false>(const int, const int, const float *, const int8_t *, const float *, float *, const float *, const int);
+template void fully_connected_inference_int8<false, true>(const int, const int, const float *, const int8_t *, const float *, float *, const float *, const int);
+template void fully_connected_inference_int8<true, false>(const int, const int, const float *, const int8_t *, const float *, float *, const float *, const int);
+template void fully_connected_inference_int8<true, true>(const int, const int, const float *, const int8_t *, const float *, float *, const float *, const int);
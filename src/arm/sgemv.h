@@ -14,9 +14,20 @@
 
 #pragma once
 #include <stdlib.h>
+#include <stdint.h>
 
 void matrixTranspose(float* array, size_t m, size_t n, float *buffer);
 void fully_connected_inference_direct(const int input_size, const int output_size, const float *x, const float *y, float *z, const int num_threads);
 void fully_connected_transpose_inference_neon8(const int input_size, const int output_size, const float *x, const float *y, float *z, const int num_threads);
 void fully_connected_inference_direct_BiasReLU(int input_size, int output_size, float *x, float *y, float *z, float* biasArr, int num_threads);
 void fully_connected_transpose_inference_neon8_BiasReLU(int input_size, int output_size, float *x, float *y, float *z, float* biasArr, int num_threads);
+
+//Symmetric int8 quantization of each row of a rows x cols matrix, w[i][j] ~ q[i][j] * scales[i].
+void quantize_rows_int8(int8_t *q, float *scales, const float *w, const int rows, const int cols);
+/*
+ * z = y * x for y quantized by quantize_rows_int8. Rows are widened to fp32 in the inner loop and
+ * every row sum is scaled once, so the weights are streamed at a quarter of their fp32 size.
+ * Bias and ReLU are applied as z is written.
+ */
+template<bool fuseBias, bool fuseRelu>
+void fully_connected_inference_int8(const int input_size, const int output_size, const float *x, const int8_t *y, const float *scales, float *z, const float *bias, const int num_threads);
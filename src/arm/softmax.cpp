@@ -0,0 +1,192 @@
+//Tencent is pleased to support the open source community by making FeatherCNN available.
+
+//Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+
+//Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+//in compliance with the License. You may obtain a copy of the License at
+//
+//https://opensource.org/licenses/BSD-3-Clause
+//
+//Unless required by applicable law or agreed to in writing, software distributed
+//under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//CONDITIONS OF ANY KIND, either express or implied. See the License for the
+//specific language governing permissions and limitations under the License.
+
+#include "softmax.h"
+#include "power.h"
+
+#include <float.h>
+#include <math.h>
+#include <vector>
+#include <arm_neon.h>
+
+#ifdef __APPLE__
+#else
+#include <omp.h>
+#endif
+
+static inline float horizontal_max(float32x4_t v)
+{
+    float32x2_t m = vmax_f32(vget_low_f32(v), vget_high_f32(v));
+    return vget_lane_f32(vpmax_f32(m, m), 0);
+}
+
+static inline float horizontal_sum(float32x4_t v)
+{
+    float32x2_t s = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+    return vget_lane_f32(vpadd_f32(s, s), 0);
+}
+
+//Maximum of a contiguous row and the sum of exp(x - max), exp(x - max) is stored to out unless it is NULL.
+static void contiguous_max_sum(float* out, const float* in, const int n, float* max_out, float* sum_out)
+{
+    float32x4_t vmax = vdupq_n_f32(-FLT_MAX);
+    int j = 0;
+    for (; j + 4 <= n; j += 4)
+        vmax = vmaxq_f32(vmax, vld1q_f32(in + j));
+    float max = horizontal_max(vmax);
+    for (; j < n; ++j)
+        max = (in[j] > max) ? in[j] : max;
+
+    vmax = vdupq_n_f32(max);
+    float32x4_t vsum = vdupq_n_f32(0.f);
+    j = 0;
+    for (; j + 4 <= n; j += 4)
+    {
+        float32x4_t e = exp_ps(vsubq_f32(vld1q_f32(in + j), vmax));
+        if (out)
+            vst1q_f32(out + j, e);
+        vsum = vaddq_f32(vsum, e);
+    }
+    float sum = horizontal_sum(vsum);
+    for (; j < n; ++j)
+    {
+        float e = expf(in[j] - max);
+        if (out)
+            out[j] = e;
+        sum += e;
+    }
+    *max_out = max;
+    *sum_out = sum;
+}
+
+//Same for a column with the given stride.
+static void strided_max_sum(const float* in, const int n, const int stride, float* max_out, float* sum_out)
+{
+    float max = -FLT_MAX;
+    for (int j = 0; j < n; ++j)
+        max = (in[j * stride] > max) ? in[j * stride] : max;
+    float sum = 0.f;
+    for (int j = 0; j < n; ++j)
+        sum += expf(in[j * stride] - max);
+    *max_out = max;
+    *sum_out = sum;
+}
+
+void softmax(float* output, const float* input, const int outer, const int n, const int inner, const int num_threads)
+{
+    if (inner == 1)
+    {
+        #pragma omp parallel for num_threads(num_threads) schedule(static)
+        for (int o = 0; o < outer; ++o)
+        {
+            float* out = output + o * n;
+            float max, sum;
+            contiguous_max_sum(out, input + o * n, n, &max, &sum);
+            const float scale = 1.f / sum;
+            int j = 0;
+            for (; j + 4 <= n; j += 4)
+                vst1q_f32(out + j, vmulq_n_f32(vld1q_f32(out + j), scale));
+            for (; j < n; ++j)
+                out[j] *= scale;
+        }
+        return;
+    }
+    //Four inner positions per vector, the middle dimension is walked with stride inner.
+    const int blocks = (inner + 3) / 4;
+    #pragma omp parallel for num_threads(num_threads) schedule(static) collapse(2)
+    for (int o = 0; o < outer; ++o)
+    {
+        for (int b = 0; b < blocks; ++b)
+        {
+            const float* in = input + o * n * inner + b * 4;
+            float* out = output + o * n * inner + b * 4;
+            if (b * 4 + 4 <= inner)
+            {
+                float32x4_t vmax = vld1q_f32(in);
+                for (int j = 1; j < n; ++j)
+                    vmax = vmaxq_f32(vmax, vld1q_f32(in + j * inner));
+                float32x4_t vsum = vdupq_n_f32(0.f);
+                for (int j = 0; j < n; ++j)
+                {
+                    float32x4_t e = exp_ps(vsubq_f32(vld1q_f32(in + j * inner), vmax));
+                    vst1q_f32(out + j * inner, e);
+                    vsum = vaddq_f32(vsum, e);
+                }
+                float32x4_t scale = vrecpeq_f32(vsum);
+                scale = vmulq_f32(vrecpsq_f32(vsum, scale), scale);
+                scale = vmulq_f32(vrecpsq_f32(vsum, scale), scale);
+                for (int j = 0; j < n; ++j)
+                    vst1q_f32(out + j * inner, vmulq_f32(vld1q_f32(out + j * inner), scale));
+            }
+            else
+            {
+                for (int i = 0; b * 4 + i < inner; ++i)
+                {
+                    float max, sum;
+                    strided_max_sum(in + i, n, inner, &max, &sum);
+                    const float scale = 1.f / sum;
+                    for (int j = 0; j < n; ++j)
+                        out[j * inner + i] = expf(in[j * inner + i] - max) * scale;
+                }
+            }
+        }
+    }
+}
+
+void topk(float* indices, float* values, const float* input, const int outer, const int n, const int inner,
+          const int top_k, const bool probabilities, const int num_threads)
+{
+    #pragma omp parallel num_threads(num_threads)
+    {
+        std::vector<int> best(top_k);
+        #pragma omp for schedule(static) collapse(2)
+        for (int o = 0; o < outer; ++o)
+        {
+            for (int i = 0; i < inner; ++i)
+            {
+                const float* in = input + o * n * inner + i;
+                //Insertion into the sorted list of the best indices so far, strict comparison keeps the lower index on ties.
+                int count = 0;
+                for (int j = 0; j < n; ++j)
+                {
+                    const float v = in[j * inner];
+                    if (count == top_k && !(v > in[best[count - 1] * inner]))
+                        continue;
+                    int pos = (count < top_k) ? count++ : count - 1;
+                    for (; pos > 0 && v > in[best[pos - 1] * inner]; --pos)
+                        best[pos] = best[pos - 1];
+                    best[pos] = j;
+                }
+                float max = 0.f, scale = 1.f;
+                if (probabilities && values)
+                {
+                    float sum;
+                    if (inner == 1)
+                        contiguous_max_sum(NULL, in, n, &max, &sum);
+                    else
+                        strided_max_sum(in, n, inner, &max, &sum);
+                    scale = 1.f / sum;
+                }
+                for (int k = 0; k < count; ++k)
+                {
+                    const int dst = (o * top_k + k) * inner + i;
+                    if (indices)
+                        indices[dst] = best[k];
+                    if (values)
+                        values[dst] = probabilities ? expf(in[best[k] * inner] - max) * scale : in[best[k] * inner];
+                }
+            }
+        }
+    }
+}
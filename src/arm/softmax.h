@@ -0,0 +1,30 @@
+//Tencent is pleased to support the open source community by making FeatherCNN available.
+
+//Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+
+//Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+//in compliance with the License. You may obtain a copy of the License at
+//
+//https://opensource.org/licenses/BSD-3-Clause
+//
+//Unless required by applicable law or agreed to in writing, software distributed
+//under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//CONDITIONS OF ANY KIND, either express or implied. See the License for the
+//specific language governing permissions and limitations under the License.
+
+#pragma once
+
+/*
+ * Softmax over the middle dimension of an outer x n x inner array, with the maximum subtracted
+ * before exponentiation. Threads split the outer dimension and blocks of four inner positions.
+ */
+void softmax(float* output, const float* input, const int outer, const int n, const int inner, const int num_threads);
+
+/*
+ * Top k elements along the middle dimension, in descending order, ties going to the lower index.
+ * Entry j of position (o, i) goes to (o * top_k + j) * inner + i of indices and values, either of
+ * which may be NULL. With probabilities the values are the softmax of the picked elements,
+ * otherwise the elements themselves.
+ */
+void topk(float* indices, float* values, const float* input, const int outer, const int n, const int inner,
+          const int top_k, const bool probabilities, const int num_threads);
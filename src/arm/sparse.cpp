@@ -0,0 +1,204 @@
+//Tencent is pleased to support the open source community by making FeatherCNN available.
+
+//Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+
+//Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+//in compliance with the License. You may obtain a copy of the License at
+//
+//https://opensource.org/licenses/BSD-3-Clause
+//
+//Unless required by applicable law or agreed to in writing, software distributed
+//under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//CONDITIONS OF ANY KIND, either express or implied. See the License for the
+//specific language governing permissions and limitations under the License.
+
+#include "sparse.h"
+
+#include <arm_neon.h>
+
+#ifdef __APPLE__
+#else
+#include <omp.h>
+#endif
+
+//Whether column k of row group g has a nonzero entry.
+static inline bool block_nonzero(const float* a, const int M, const int K, const int g, const int k)
+{
+    for (int r = 4 * g; r < 4 * g + 4 && r < M; ++r)
+    {
+        if (a[r * K + k] != 0.f)
+            return true;
+    }
+    return false;
+}
+
+float block_sparsity(const float* a, const int M, const int K)
+{
+    const int groups = (M + 3) / 4;
+    if (groups == 0 || K == 0)
+        return 0.f;
+    int zero_blocks = 0;
+    for (int g = 0; g < groups; ++g)
+        for (int k = 0; k < K; ++k)
+            zero_blocks += block_nonzero(a, M, K, g, k) ? 0 : 1;
+    return (float) zero_blocks / (groups * K);
+}
+
+void block_sparse_encode(BlockSparseMatrix* sparse, const float* a, const int M, const int K)
+{
+    const int groups = (M + 3) / 4;
+    sparse->rows = M;
+    sparse->cols = K;
+    sparse->group_begin.assign(1, 0);
+    sparse->block_col.clear();
+    sparse->values.clear();
+    for (int g = 0; g < groups; ++g)
+    {
+        for (int k = 0; k < K; ++k)
+        {
+            if (!block_nonzero(a, M, K, g, k))
+                continue;
+            sparse->block_col.push_back(k);
+            for (int r = 4 * g; r < 4 * g + 4; ++r)
+                sparse->values.push_back((r < M) ? a[r * K + k] : 0.f);
+        }
+        sparse->group_begin.push_back((int) sparse->block_col.size());
+    }
+}
+
+template<bool fuseBias, bool fuseRelu>
+static inline void store_row(float* c, float32x4_t v, const float bias)
+{
+    if (fuseBias)
+        v = vaddq_f32(v, vdupq_n_f32(bias));
+    if (fuseRelu)
+        v = vmaxq_f32(v, vdupq_n_f32(0.f));
+    vst1q_f32(c, v);
+}
+
+template<bool fuseBias, bool fuseRelu>
+static inline void store_scalar(float* c, float v, const float bias)
+{
+    if (fuseBias)
+        v += bias;
+    if (fuseRelu)
+        v = (v > 0.f) ? v : 0.f;
+    *c = v;
+}
+
+//Rows [4g, 4g + rows) of C for columns [n_begin, n_end).
+template<bool fuseBias, bool fuseRelu>
+static void sparse_group_panel(const BlockSparseMatrix& a, const int g, const int rows, const int n_begin, const int n_end,
+                               const float* b, const int ldb, float* c, const int ldc, const float* bias)
+{
+    const int block_begin = a.group_begin[g];
+    const int block_end = a.group_begin[g + 1];
+    float bias_r[4] = {0.f, 0.f, 0.f, 0.f};
+    if (fuseBias)
+        for (int r = 0; r < rows; ++r)
+            bias_r[r] = bias[4 * g + r];
+    float* c_g = c + 4 * g * ldc;
+    int n = n_begin;
+    for (; n + 8 <= n_end; n += 8)
+    {
+        float32x4_t acc[4][2];
+        for (int r = 0; r < 4; ++r)
+        {
+            acc[r][0] = vdupq_n_f32(0.f);
+            acc[r][1] = vdupq_n_f32(0.f);
+        }
+        for (int blk = block_begin; blk < block_end; ++blk)
+        {
+            const float* bp = b + a.block_col[blk] * ldb + n;
+            const float* w = &a.values[4 * blk];
+            const float32x4_t b0 = vld1q_f32(bp);
+            const float32x4_t b1 = vld1q_f32(bp + 4);
+            for (int r = 0; r < 4; ++r)
+            {
+                acc[r][0] = vmlaq_n_f32(acc[r][0], b0, w[r]);
+                acc[r][1] = vmlaq_n_f32(acc[r][1], b1, w[r]);
+            }
+        }
+        for (int r = 0; r < rows; ++r)
+        {
+            store_row<fuseBias, fuseRelu>(c_g + r * ldc + n, acc[r][0], bias_r[r]);
+            store_row<fuseBias, fuseRelu>(c_g + r * ldc + n + 4, acc[r][1], bias_r[r]);
+        }
+    }
+    for (; n + 4 <= n_end; n += 4)
+    {
+        float32x4_t acc[4];
+        for (int r = 0; r < 4; ++r)
+            acc[r] = vdupq_n_f32(0.f);
+        for (int blk = block_begin; blk < block_end; ++blk)
+        {
+            const float32x4_t b0 = vld1q_f32(b + a.block_col[blk] * ldb + n);
+            const float* w = &a.values[4 * blk];
+            for (int r = 0; r < 4; ++r)
+                acc[r] = vmlaq_n_f32(acc[r], b0, w[r]);
+        }
+        for (int r = 0; r < rows; ++r)
+            store_row<fuseBias, fuseRelu>(c_g + r * ldc + n, acc[r], bias_r[r]);
+    }
+    for (; n < n_end; ++n)
+    {
+        //The 4 rows of one column fit in a vector.
+        float32x4_t acc = vdupq_n_f32(0.f);
+        for (int blk = block_begin; blk < block_end; ++blk)
+            acc = vmlaq_n_f32(acc, vld1q_f32(&a.values[4 * blk]), b[a.block_col[blk] * ldb + n]);
+        float out[4];
+        vst1q_f32(out, acc);
+        for (int r = 0; r < rows; ++r)
+            store_scalar<fuseBias, fuseRelu>(c_g + r * ldc + n, out[r], bias_r[r]);
+    }
+}
+
+template<bool fuseBias, bool fuseRelu>
+void block_sparse_sgemm(const BlockSparseMatrix& a, const int N, const float* b, const int ldb,
+                        float* c, const int ldc, const float* bias, const int num_threads)
+{
+    const int groups = (a.rows + 3) / 4;
+    //Columns per panel, a K x panel slice of B is ~64KB.
+    int panel = (16384 / (a.cols > 0 ? a.cols : 1)) & ~7;
+    panel = (panel < 8) ? 8 : panel;
+    const int panels = (N + panel - 1) / panel;
+    #pragma omp parallel for num_threads(num_threads) collapse(2) schedule(static)
+    for (int p = 0; p < panels; ++p)
+    {
+        for (int g = 0; g < groups; ++g)
+        {
+            const int n_begin = p * panel;
+            const int n_end = (n_begin + panel < N) ? n_begin + panel : N;
+            const int rows = (a.rows - 4 * g < 4) ? a.rows - 4 * g : 4;
+            sparse_group_panel<fuseBias, fuseRelu>(a, g, rows, n_begin, n_end, b, ldb, c, ldc, bias);
+        }
+    }
+}
+
+template<bool fuseBias, bool fuseRelu>
+void block_sparse_sgemv(const BlockSparseMatrix& a, const float* x, float* y, const float* bias, const int num_threads)
+{
+    const int groups = (a.rows + 3) / 4;
+    #pragma omp parallel for num_threads(num_threads) schedule(static)
+    for (int g = 0; g < groups; ++g)
+    {
+        float32x4_t acc = vdupq_n_f32(0.f);
+        for (int blk = a.group_begin[g]; blk < a.group_begin[g + 1]; ++blk)
+            acc = vmlaq_n_f32(acc, vld1q_f32(&a.values[4 * blk]), x[a.block_col[blk]]);
+        const int rows = (a.rows - 4 * g < 4) ? a.rows - 4 * g : 4;
+        float out[4];
+        vst1q_f32(out, acc);
+        for (int r = 0; r < rows; ++r)
+            store_scalar<fuseBias, fuseRelu>(y + 4 * g + r, out[r], fuseBias ? bias[4 * g + r] : 0.f);
+    }
+}
+
+template void block_sparse_sgemm<false, false>(const BlockSparseMatrix&, const int, const float*, const int, float*, const int, const float*, const int);
+template void block_sparse_sgemm<false, true>(const BlockSparseMatrix&, const int, const float*, const int, float*, const int, const float*, const int);
+template void block_sparse_sgemm<true, false>(const BlockSparseMatrix&, const int, const float*, const int, float*, const int, const float*, const int);
+template void block_sparse_sgemm<true, true>(const BlockSparseMatrix&, const int, const float*, const int, float*, const int, const float*, const int);
+
+template void block_sparse_sgemv<false, false>(const BlockSparseMatrix&, const float*, float*, const float*, const int);
+template void block_sparse_sgemv<false, true>(const BlockSparseMatrix&, const float*, float*, const float*, const int);
+template void block_sparse_sgemv<true, false>(const BlockSparseMatrix&, const float*, float*, const float*, const int);
+template void block_sparse_sgemv<true, true>(const BlockSparseMatrix&, const float*, float*, const float*, const int);
@@ -0,0 +1,49 @@
+//Tencent is pleased to support the open source community by making FeatherCNN available.
+
+//Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+
+//Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+//in compliance with the License. You may obtain a copy of the License at
+//
+//https://opensource.org/licenses/BSD-3-Clause
+//
+//Unless required by applicable law or agreed to in writing, software distributed
+//under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//CONDITIONS OF ANY KIND, either express or implied. See the License for the
+//specific language governing permissions and limitations under the License.
+
+#pragma once
+
+#include <vector>
+
+/*
+ * M x K weights kept as blocks of 4 rows by 1 column, zero blocks dropped. Blocks of row group g
+ * are [group_begin[g], group_begin[g + 1]), block b holds column block_col[b] of rows
+ * 4g .. 4g + 3 in values[4b .. 4b + 3]. The rows of the last group past M are zero.
+ */
+struct BlockSparseMatrix
+{
+    int rows;
+    int cols;
+    std::vector<int> group_begin;
+    std::vector<int> block_col;
+    std::vector<float> values;
+};
+
+//Fraction of the 4x1 blocks of a row major M x K matrix that are all zero.
+float block_sparsity(const float* a, const int M, const int K);
+
+void block_sparse_encode(BlockSparseMatrix* sparse, const float* a, const int M, const int K);
+
+/*
+ * C = A * B for a block sparse A and a dense K x N B. Threads split row groups and column
+ * panels of B sized to stay in L2, every nonzero block updates 4 rows by 8 columns of C in
+ * registers. Bias (per row) and ReLU are applied as C is written.
+ */
+template<bool fuseBias, bool fuseRelu>
+void block_sparse_sgemm(const BlockSparseMatrix& a, const int N, const float* b, const int ldb,
+                        float* c, const int ldc, const float* bias, const int num_threads);
+
+//y = A * x, with the same fusions.
+template<bool fuseBias, bool fuseRelu>
+void block_sparse_sgemv(const BlockSparseMatrix& a, const float* x, float* y, const float* bias, const int num_threads);
@@ -116,13 +116,14 @@ void winogradKernelTransform(float* transKernel, float* kernel)
 {
     float32x4_t w0, w1, w2, w3;
     float32x4_t s0, s1, s2, s3;
+    //The last row is loaded from a copy, a 4 wide load would read past the kernel.
+    float last_row[4] = {kernel[6], kernel[7], kernel[8], 0.f};
 
     w0 = vld1q_f32(kernel);
     w0 = vsetq_lane_f32(0.f, w0, 3);
     w1 = vld1q_f32(kernel + 3);
     w1 = vsetq_lane_f32(0.f, w1, 3);
-    w2 = vld1q_f32(kernel + 6);
-    w2 = vsetq_lane_f32(0.f, w2, 3);
+    w2 = vld1q_f32(last_row);
     w3 = vdupq_n_f32(0.f);
 
     float32x4_t vhalf = vdupq_n_f32(0.5);
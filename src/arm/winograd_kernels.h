@@ -30,3 +30,13 @@ void winogradNonFusedTransform(float *output, int outChannels, float* WT, float*
 size_t getPackArraySize_F6x6_3x3(int inChannels, int num_threads);
 void transformKernel_F6x6_3x3(float* UT, float* kernel, int inChannels, int outChannels);
 void winogradNonFusedTransform_F6x6_3x3(float *output, int outChannels, float* WT, float* VT, float* UT, float* input, int inChannels, int inputw, int inputh, WinogradOutType outType, float* biasArr, float* pack_array, int num_threads);
+//Output rows [row_begin, row_end) only, output holds (row_end - row_begin) rows per channel.
+void winogradNonFusedTransformRows_F6x6_3x3(float *output, int outChannels, float* WT, float* VT, float* UT, float* input, int inChannels, int inputh, int inputw, int row_begin, int row_end, WinogradOutType outType, float* biasArr, float* pack_array, int num_threads);
+
+//Batched multiplication of transformed tiles shared by F(6x6, 3x3) and F(4x4, 3x3), depth counts groups of 4 tile elements.
+void TensorGEMM(float *WT, const float *VT, const float *UT, const int depth, const int inChannels, const int outChannels, const int nRowBlocks, const int nColBlocks, const int num_threads, float* pack_arr, const int cache_block);
+
+size_t getPackArraySize_F4x4_3x3(int inChannels, int num_threads);
+void transformKernel_F4x4_3x3(float* UT, float* kernel, int inChannels, int outChannels);
+void winogradNonFusedTransform_F4x4_3x3(float *output, int outChannels, float* WT, float* VT, float* UT, float* input, int inChannels, int inputh, int inputw, WinogradOutType outType, float* biasArr, float* pack_array, int num_threads);
+void winogradNonFusedTransformRows_F4x4_3x3(float *output, int outChannels, float* WT, float* VT, float* UT, float* input, int inChannels, int inputh, int inputw, int row_begin, int row_end, WinogradOutType outType, float* biasArr, float* pack_array, int num_threads);
@@ -0,0 +1,298 @@
+//Tencent is pleased to support the open source community by making FeatherCNN available.
+
+//Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+
+//Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+//in compliance with the License. You may obtain a copy of the License at
+//
+//https://opensource.org/licenses/BSD-3-Clause
+//
+//Unless required by applicable law or agreed to in writing, software distributed
+//under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//CONDITIONS OF ANY KIND, either express or implied. See the License for the
+//specific language governing permissions and limitations under the License.
+
+#include "winograd_kernels.h"
+#include "helper.h"
+#include <stdlib.h>
+#include <arm_neon.h>
+#include <assert.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/*
+ * F(4x4, 3x3): 6x6 input tiles with a stride of 4 give 4x4 output tiles.
+ * The transformed tiles are stored like in F(6x6, 3x3), with 36 instead of 64 elements, so that
+ * TensorGEMM is shared with a depth of 9.
+ *
+ * The input and output transforms keep four horizontally adjacent tiles in the lanes of a vector.
+ *
+ G =
+ ⎡ 1/4     0     0  ⎤
+ ⎢-1/6   -1/6  -1/6 ⎥
+ ⎢-1/6    1/6  -1/6 ⎥
+ ⎢1/24   1/12   1/6 ⎥
+ ⎢1/24  -1/12   1/6 ⎥
+ ⎣  0      0     1  ⎦
+ BT =
+ ⎡4   0  -5   0  1  0⎤
+ ⎢0  -4  -4   1  1  0⎥
+ ⎢0   4  -4  -1  1  0⎥
+ ⎢0  -2  -1   2  1  0⎥
+ ⎢0   2  -1  -2  1  0⎥
+ ⎣0   4   0  -5  0  1⎦
+ AT =
+ ⎡1  1   1  1   1  0⎤
+ ⎢0  1  -1  2  -2  0⎥
+ ⎢0  1   1  4   4  0⎥
+ ⎣0  1  -1  8  -8  1⎦
+ */
+
+static const int kTileElems = 36;
+static const int kDepth = 9;
+
+static inline void transpose4x4(float32x4_t &r0, float32x4_t &r1, float32x4_t &r2, float32x4_t &r3)
+{
+    float32x4x2_t t01 = vtrnq_f32(r0, r1);
+    float32x4x2_t t23 = vtrnq_f32(r2, r3);
+    r0 = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+    r1 = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+    r2 = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+    r3 = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+}
+
+//BT applied to d[0], d[s], ..., d[5s].
+static inline void input_transform_F43(float32x4_t *d, int s)
+{
+    const float32x4_t f4 = vdupq_n_f32(4.0f);
+    const float32x4_t f5 = vdupq_n_f32(5.0f);
+    float32x4_t d0 = d[0], d1 = d[s], d2 = d[2 * s], d3 = d[3 * s], d4 = d[4 * s], d5 = d[5 * s];
+    float32x4_t t0 = vmlsq_f32(d4, d2, f4);
+    float32x4_t t1 = vmlsq_f32(d3, d1, f4);
+    float32x4_t t2 = vsubq_f32(d4, d2);
+    float32x4_t t3 = vsubq_f32(d3, d1);
+    t3 = vaddq_f32(t3, t3);
+    d[0] = vmlsq_f32(vmlaq_f32(d4, d0, f4), d2, f5);
+    d[s] = vaddq_f32(t0, t1);
+    d[2 * s] = vsubq_f32(t0, t1);
+    d[3 * s] = vaddq_f32(t2, t3);
+    d[4 * s] = vsubq_f32(t2, t3);
+    d[5 * s] = vmlsq_f32(vmlaq_f32(d5, d1, f4), d3, f5);
+}
+
+//AT applied to m[0], m[s], ..., m[5s], results go to o[0], o[os], ..., o[3os].
+static inline void output_transform_F43(float32x4_t *o, int os, const float32x4_t *m, int s)
+{
+    const float32x4_t f2 = vdupq_n_f32(2.0f);
+    const float32x4_t f4 = vdupq_n_f32(4.0f);
+    const float32x4_t f8 = vdupq_n_f32(8.0f);
+    float32x4_t a = vaddq_f32(m[s], m[2 * s]);
+    float32x4_t b = vsubq_f32(m[s], m[2 * s]);
+    float32x4_t c = vaddq_f32(m[3 * s], m[4 * s]);
+    float32x4_t d = vsubq_f32(m[3 * s], m[4 * s]);
+    o[0] = vaddq_f32(vaddq_f32(m[0], a), c);
+    o[os] = vmlaq_f32(b, d, f2);
+    o[2 * os] = vmlaq_f32(a, c, f4);
+    o[3 * os] = vaddq_f32(vmlaq_f32(b, d, f8), m[5 * s]);
+}
+
+//Group g of the transformed tile bid starts here, the trailing tiles that don't fill a group of four are packed tighter.
+static inline float *tile_group_ptr(float *base, int bid, int g, int nBlocksAligned, int rem)
+{
+    float *p = base + (bid & 0xFFFFFFFC) * kTileElems + (bid & 0x3) * 4;
+    return p + g * ((bid < nBlocksAligned) ? 16 : rem * 4);
+}
+
+void transformKernel_F4x4_3x3(float *UT, float *kernel, int inChannels, int outChannels)
+{
+    const float ktm[18] =
+    {
+        1.0f / 4, 0.0f, 0.0f,
+        -1.0f / 6, -1.0f / 6, -1.0f / 6,
+        -1.0f / 6, 1.0f / 6, -1.0f / 6,
+        1.0f / 24, 1.0f / 12, 1.0f / 6,
+        1.0f / 24, -1.0f / 12, 1.0f / 6,
+        0.0f, 0.0f, 1.0f
+    };
+    for (int j = 0; j < outChannels; ++j)
+    {
+        for (int i = 0; i < inChannels; ++i)
+        {
+            const float *k = kernel + 9 * (j * inChannels + i);
+            float tmp[18];
+            for (int r = 0; r < 6; ++r)
+                for (int c = 0; c < 3; ++c)
+                    tmp[r * 3 + c] = ktm[r * 3] * k[c] + ktm[r * 3 + 1] * k[3 + c] + ktm[r * 3 + 2] * k[6 + c];
+            //Same packing as F(6x6, 3x3): every 4 output channels, groups of 4 elements, input channels.
+            float *UTp = UT + (j / 4) * (16 * kDepth * inChannels) + 16 * i + (j & 0x3) * 4;
+            for (int r = 0; r < 6; ++r)
+            {
+                for (int c = 0; c < 6; ++c)
+                {
+                    int e = r * 6 + c;
+                    UTp[(e / 4) * 16 * inChannels + e % 4] = tmp[r * 3] * ktm[c * 3] + tmp[r * 3 + 1] * ktm[c * 3 + 1] + tmp[r * 3 + 2] * ktm[c * 3 + 2];
+                }
+            }
+        }
+    }
+}
+
+static void winogradInputTransform_F43(float *VT, int inChannels, const float *input, int inputh, int inputw, int frameStride, int ldin, int nRowBlocks, int nColBlocks, int num_threads)
+{
+    const int nBlocks = nRowBlocks * nColBlocks;
+    const int nBlocksAligned = nBlocks & 0xFFFFFFFC;
+    const int rem = nBlocks & 0x3;
+    #pragma omp parallel for num_threads(num_threads) collapse(2) schedule(static)
+    for (int ic = 0; ic < inChannels; ++ic)
+    {
+        for (int j = 0; j < nColBlocks; ++j)
+        {
+            float *VTp = VT + ic * nBlocks * kTileElems;
+            float32x4_t d[36];
+            float ext[6 * 20];
+            for (int i = 0; i < nRowBlocks; i += 4)
+            {
+                //Four tiles read columns [4i, 4i + 18), the loads below touch up to 4i + 20.
+                const float *p = input + ic * frameStride + j * 4 * ldin + i * 4;
+                int ld = ldin;
+                if (j * 4 + 6 > inputh || i * 4 + 20 > inputw)
+                {
+                    int step_h = inputh - j * 4;
+                    int step_w = inputw - i * 4;
+                    step_h = (step_h > 6) ? 6 : step_h;
+                    step_w = (step_w > 20) ? 20 : step_w;
+                    memset(ext, 0, sizeof(ext));
+                    for (int n = 0; n < step_h; ++n)
+                        memcpy(ext + n * 20, p + n * ldin, sizeof(float) * step_w);
+                    p = ext;
+                    ld = 20;
+                }
+                for (int r = 0; r < 6; ++r)
+                {
+                    float32x4x4_t lo = vld4q_f32(p + r * ld);
+                    float32x4x4_t hi = vld4q_f32(p + r * ld + 4);
+                    d[r * 6 + 0] = lo.val[0];
+                    d[r * 6 + 1] = lo.val[1];
+                    d[r * 6 + 2] = lo.val[2];
+                    d[r * 6 + 3] = lo.val[3];
+                    d[r * 6 + 4] = hi.val[0];
+                    d[r * 6 + 5] = hi.val[1];
+                }
+                for (int c = 0; c < 6; ++c)
+                    input_transform_F43(d + c, 6);
+                for (int r = 0; r < 6; ++r)
+                    input_transform_F43(d + r * 6, 1);
+                const int tiles = (nRowBlocks - i < 4) ? nRowBlocks - i : 4;
+                for (int g = 0; g < kDepth; ++g)
+                {
+                    float32x4_t *v = d + g * 4;
+                    transpose4x4(v[0], v[1], v[2], v[3]);
+                    for (int t = 0; t < tiles; ++t)
+                        vst1q_f32(tile_group_ptr(VTp, j * nRowBlocks + i + t, g, nBlocksAligned, rem), v[t]);
+                }
+            }
+        }
+    }
+}
+
+template<bool HAS_RELU, bool HAS_BIAS>
+static void winogradOutputTransform_F43(float *output, int outputh, int outputw, int ldout, float *WT, int outChannels, int nRowBlocks, int nColBlocks, float *biasArr, int num_threads)
+{
+    const int nBlocks = nRowBlocks * nColBlocks;
+    const int nBlocksAligned = nBlocks & 0xFFFFFFFC;
+    const int rem = nBlocks & 0x3;
+    const float32x4_t vZero = vdupq_n_f32(0.f);
+    #pragma omp parallel for num_threads(num_threads) collapse(2) schedule(static)
+    for (int oc = 0; oc < outChannels; ++oc)
+    {
+        for (int j = 0; j < nColBlocks; ++j)
+        {
+            float *WTp = WT + oc * nBlocks * kTileElems;
+            float *outFrame = output + oc * outputh * outputw + j * 4 * ldout;
+            const float32x4_t vBias = HAS_BIAS ? vdupq_n_f32(biasArr[oc]) : vZero;
+            float32x4_t m[36];
+            float32x4_t o[24];
+            float ext[4 * 16];
+            for (int i = 0; i < nRowBlocks; i += 4)
+            {
+                const int tiles = (nRowBlocks - i < 4) ? nRowBlocks - i : 4;
+                for (int g = 0; g < kDepth; ++g)
+                {
+                    float32x4_t *v = m + g * 4;
+                    for (int t = 0; t < 4; ++t)
+                        v[t] = (t < tiles) ? vld1q_f32(tile_group_ptr(WTp, j * nRowBlocks + i + t, g, nBlocksAligned, rem)) : vZero;
+                    transpose4x4(v[0], v[1], v[2], v[3]);
+                }
+                int step_h = outputh - j * 4;
+                int step_w = outputw - i * 4;
+                step_h = (step_h > 4) ? 4 : step_h;
+                step_w = (step_w > 16) ? 16 : step_w;
+                //Edge tiles go through ext.
+                const bool edge = (step_h < 4 || step_w < 16);
+                //Columns first into o as 4 rows of 6, then the rows into 4x4.
+                for (int c = 0; c < 6; ++c)
+                    output_transform_F43(o + c, 6, m + c, 6);
+                for (int r = 0; r < 4; ++r)
+                {
+                    float32x4x4_t row;
+                    output_transform_F43(row.val, 1, o + r * 6, 1);
+                    for (int c = 0; c < 4; ++c)
+                    {
+                        if (HAS_BIAS)
+                            row.val[c] = vaddq_f32(row.val[c], vBias);
+                        if (HAS_RELU)
+                            row.val[c] = vmaxq_f32(row.val[c], vZero);
+                    }
+                    vst4q_f32(edge ? ext + r * 16 : outFrame + r * ldout + i * 4, row);
+                }
+                for (int r = 0; edge && r < step_h; ++r)
+                    memcpy(outFrame + r * ldout + i * 4, ext + r * 16, sizeof(float) * step_w);
+            }
+        }
+    }
+}
+
+size_t getPackArraySize_F4x4_3x3(int inChannels, int num_threads)
+{
+    return 32 * num_threads * inChannels * kTileElems;
+}
+
+static void winogradNonFusedTransform_F43_inner(float *output, int ldout, float *WT, float *VT, float *UT, int inChannels, int outChannels, float *input, int inputh, int inputw, int frameStride, int ldin, WinogradOutType outType, float *biasArr, float *pack_array, int num_threads)
+{
+    const int nRowBlocks = (inputw + 1) / 4;
+    const int nColBlocks = (inputh + 1) / 4;
+    const int outputh = inputh - 2;
+    const int outputw = inputw - 2;
+    winogradInputTransform_F43(VT, inChannels, input, inputh, inputw, frameStride, ldin, nRowBlocks, nColBlocks, num_threads);
+    TensorGEMM(WT, VT, UT, kDepth, inChannels, outChannels, nRowBlocks, nColBlocks, num_threads, pack_array, num_threads * 32);
+    switch (outType)
+    {
+        case None:
+            winogradOutputTransform_F43<false, false>(output, outputh, outputw, ldout, WT, outChannels, nRowBlocks, nColBlocks, biasArr, num_threads);
+            break;
+        case ReLU:
+            winogradOutputTransform_F43<true, false>(output, outputh, outputw, ldout, WT, outChannels, nRowBlocks, nColBlocks, biasArr, num_threads);
+            break;
+        case Bias:
+            winogradOutputTransform_F43<false, true>(output, outputh, outputw, ldout, WT, outChannels, nRowBlocks, nColBlocks, biasArr, num_threads);
+            break;
+        case BiasReLU:
+            winogradOutputTransform_F43<true, true>(output, outputh, outputw, ldout, WT, outChannels, nRowBlocks, nColBlocks, biasArr, num_threads);
+            break;
+    }
+}
+
+void winogradNonFusedTransform_F4x4_3x3(float *output, int outChannels, float *WT, float *VT, float *UT, float *input, int inChannels, int inputh, int inputw, WinogradOutType outType, float *biasArr, float *pack_array, int num_threads)
+{
+    winogradNonFusedTransform_F43_inner(output, inputw - 2, WT, VT, UT, inChannels, outChannels, input, inputh, inputw, inputw * inputh, inputw, outType, biasArr, pack_array, num_threads);
+}
+
+void winogradNonFusedTransformRows_F4x4_3x3(float *output, int outChannels, float *WT, float *VT, float *UT, float *input, int inChannels, int inputh, int inputw, int row_begin, int row_end, WinogradOutType outType, float *biasArr, float *pack_array, int num_threads)
+{
+    //The band reads two extra input rows, the frame stride stays the one of the whole input.
+    const int bandh = row_end - row_begin + 2;
+    winogradNonFusedTransform_F43_inner(output, inputw - 2, WT, VT, UT, inChannels, outChannels, input + row_begin * inputw, bandh, inputw, inputw * inputh, inputw, outType, biasArr, pack_array, num_threads);
+}
@@ -576,6 +576,8 @@ void TensorGEMM(float *WT, const float *VT, const float *UT, const int depth, co
         end_block_id = (end_block_id > nBlocks) ? nBlocks : end_block_id;
         int end_block_id_aligned = end_block_id & 0xFFFFFFFC;
         const int rem = end_block_id % 4;
+        //Only step into the remainder when there is one, the pack array has no room past a full pass.
+        const int end_block_id_loop = (rem > 0) ? end_block_id_aligned + 4 : end_block_id_aligned;
 
 
         /*I have no idea which packing method is faster, seeems that they are not the major bottleneck after loop swapping*/
@@ -590,7 +592,7 @@ void TensorGEMM(float *WT, const float *VT, const float *UT, const int depth, co
             #pragma omp for collapse(2)
 #endif
 #endif
-            for (int i = start_block_id; i < end_block_id_aligned + 4; i += 4)
+            for (int i = start_block_id; i < end_block_id_loop; i += 4)
             {
                 for (int d = 0; d < depth; ++d)
                 {
@@ -648,7 +650,7 @@ void TensorGEMM(float *WT, const float *VT, const float *UT, const int depth, co
             for (int oc = 0; oc < outChannels; oc += 4)
             {
 #endif
-                for (int i = start_block_id; i < end_block_id_aligned + 4; i += 4)
+                for (int i = start_block_id; i < end_block_id_loop; i += 4)
                 {
                     for (int d = 0; d < depth; ++d)
                     {
@@ -657,7 +659,7 @@ void TensorGEMM(float *WT, const float *VT, const float *UT, const int depth, co
                             const float *UTp = UT + d * 16 * inChannels + oc / 4 * inChannels * 16 * depth;
                             const float *vp = pack_arr
                                               + (i - start_block_id) * inChannels * depth * 4//which block
-                                              + d * depth * inChannels;
+                                              + d * 16 * inChannels;
                             float *WTp = WT + oc * wstride + i * depth * 4 + d * 16 + (i % 4) * 4;
                             TensorGEMMInnerKernel4x4x4(WTp, wstride, UTp, vp, inChannels);
                         }
@@ -673,7 +675,7 @@ void TensorGEMM(float *WT, const float *VT, const float *UT, const int depth, co
                             const float *vp = pack_arr
                                               //+ tid * cache_block * inChannels * depth * 4//which thread
                                               + (i - start_block_id) * inChannels * depth * 4//which block
-                                              + d * depth * inChannels * (4 * len) / 16;
+                                              + d * inChannels * 4 * len;
                             float *WTp = WT + oc * wstride + i * depth * 4 + d * 4 * len + (i % 4) * 4;
                             if (len == 1)
                             {
@@ -1280,3 +1282,13 @@ void winogradNonFusedTransform_F6x6_3x3(float *output, int outChannels, float *W
     //printf("ldout = %d\n", ldout);
     winogradNonFusedTransform_inner(output, ldout, WT, VT, UT, inChannels, outChannels, input, inputh, inputw, inputFrameStride, inputw, nRowBlocks, nColBlocks, outType, biasArr, pack_array, num_threads);
 }
+
+void winogradNonFusedTransformRows_F6x6_3x3(float *output, int outChannels, float *WT, float *VT, float *UT, float *input, int inChannels, int inputh, int inputw, int row_begin, int row_end, WinogradOutType outType, float *biasArr, float* pack_array, int num_threads)
+{
+    //The band reads two extra input rows, the frame stride stays the one of the whole input.
+    const int bandh = row_end - row_begin + 2;
+    const int nRowBlocks = (inputw + 3) / 6;
+    const int nColBlocks = (bandh + 3) / 6;
+    const int ldout = inputw - 2;
+    winogradNonFusedTransform_inner(output, ldout, WT, VT, UT, inChannels, outChannels, input + row_begin * inputw, bandh, inputw, inputw * inputh, inputw, nRowBlocks, nColBlocks, outType, biasArr, pack_array, num_threads);
+}
@@ -24,17 +24,30 @@ namespace feather
 template<class Dtype>
 void Blob<Dtype>::Alloc()
 {
-    size_t dim_byte = _num * _channels * _height * _width * sizeof(Dtype);
+    size_t dim_byte = data_size() * sizeof(Dtype);
     _data = (Dtype*) _mm_malloc(dim_byte, 16);
+    _capacity = data_size();
+    _owns_data = true;
 }
 template<class Dtype>
 void Blob<Dtype>::Free()
 {
 	if (this->_data)
 	{
-		free(this->_data);
+		if (_owns_data)
+			free(this->_data);
 		this->_data = NULL;
 	}
+	_capacity = 0;
+}
+
+template<class Dtype>
+void Blob<Dtype>::BindData(Dtype* data, size_t elem_size)
+{
+    Free();
+    _data = data;
+    _capacity = elem_size;
+    _owns_data = false;
 }
 
 template<class Dtype>
@@ -52,7 +65,8 @@ template<class Dtype>
 void Blob<Dtype>::ReshapeWithRealloc(int num, int channels, int height, int width)
 {
     // LOGI("Reallc: (%d %d %d %d) to (%d %d %d %d)", _num, _channels, _height, _width, num, channels, height, width);
-    int elem_size = num * channels * height * width;
+    int aligned = (_layout == NC4HW4) ? (channels + 3) / 4 * 4 : channels;
+    int elem_size = num * aligned * height * width;
     Realloc(elem_size);
     this->_num      = num;
     this->_channels = channels;
@@ -63,10 +77,12 @@ void Blob<Dtype>::ReshapeWithRealloc(int num, int channels, int height, int widt
 template<class Dtype>
 void Blob<Dtype>::Realloc(size_t elem_size)
 {
-    if(elem_size > this->data_size())
+    if(elem_size > _capacity)
     {
         Free();
         _data = (Dtype*) _mm_malloc(elem_size * sizeof(Dtype), 32);
+        _capacity = elem_size;
+        _owns_data = true;
     }
 }
 
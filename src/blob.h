@@ -20,22 +20,28 @@
 
 namespace feather
 {
+//NC4HW4 stores channels in blocks of four interleaved per pixel, the last block padded with zeros.
+enum BlobLayout
+{
+    NCHW, NC4HW4
+};
+
 template <class Dtype>
 class Blob
 {
     public:
         Blob()
-            : _num(0), _channels(0), _height(0), _width(0), _data(NULL) {}
+            : _num(0), _channels(0), _height(0), _width(0), _layout(NCHW), _data(NULL), _capacity(0), _owns_data(true) {}
 
         explicit Blob(const size_t num, const size_t channels, const size_t height, const size_t width)
-            : _data(NULL), _num(num), _channels(channels), _height(height), _width(width), _name() {}
+            : _data(NULL), _num(num), _channels(channels), _height(height), _width(width), _layout(NCHW), _capacity(0), _owns_data(true), _name() {}
 
 
         explicit Blob(Dtype* data, const size_t num, const size_t channels, const size_t height, const size_t width)
-            : _data(data), _num(num), _channels(channels), _height(height), _width(width), _name() {}
+            : _data(data), _num(num), _channels(channels), _height(height), _width(width), _layout(NCHW), _capacity(num * channels * height * width), _owns_data(true), _name() {}
 
         explicit Blob(Dtype* data, size_t num, size_t channels, size_t height, size_t width, std::string name)
-            : _data(data), _num(num), _channels(channels), _height(height), _width(width), _name(name) {}
+            : _data(data), _num(num), _channels(channels), _height(height), _width(width), _layout(NCHW), _capacity(num * channels * height * width), _owns_data(true), _name(name) {}
 
         ~Blob()
         {
@@ -51,9 +57,13 @@ class Blob
 
         void Realloc(size_t elem_size);
 
+        //Points the blob at elem_size elements owned elsewhere, e.g. the arena of a memory plan.
+        //Free leaves them alone and Realloc moves the blob to its own memory when it outgrows them.
+        void BindData(Dtype* data, size_t elem_size);
+
         void CopyData(const Dtype* data)
         {
-            size_t size = _num * _channels * _height * _width;
+            size_t size = data_size();
             memcpy(_data, data, sizeof(Dtype) * size);
         }
         void CopyShape(const Blob<Dtype>* p_blob)
@@ -62,6 +72,7 @@ class Blob
             this->_channels = p_blob->channels();
             this->_width = p_blob->width();
             this->_height = p_blob->height();
+            this->_layout = p_blob->layout();
         }
         void Copy(const Blob<Dtype>* p_blob)
         {
@@ -79,11 +90,24 @@ class Blob
             return _data;
         }
 
+        //Number of elements in memory, including the channel padding of NC4HW4.
         size_t data_size() const
+        {
+            return _num * aligned_channels() * _height * _width;
+        }
+
+        //Number of elements in NCHW order.
+        size_t elem_count() const
         {
             return _num * _channels * _height * _width;
         }
 
+        //Number of elements the buffer can hold, at least data_size().
+        size_t capacity() const
+        {
+            return _capacity;
+        }
+
         std::string name()
         {
             return _name;
@@ -104,6 +128,19 @@ class Blob
         {
             return _width;
         }
+        BlobLayout layout() const
+        {
+            return _layout;
+        }
+        //Only changes the interpretation, call before Alloc.
+        void set_layout(BlobLayout layout)
+        {
+            _layout = layout;
+        }
+        size_t aligned_channels() const
+        {
+            return (_layout == NC4HW4) ? (_channels + 3) / 4 * 4 : _channels;
+        }
         void PrintBlobInfo() const
         {
             printf("----BlobInfo----\n");
@@ -117,6 +154,9 @@ class Blob
         size_t _channels;
         size_t _height;
         size_t _width;
+        BlobLayout _layout;
+        size_t _capacity;
+        bool _owns_data;
 
         std::string _name;
 };
@@ -80,6 +80,10 @@ struct BlobShape;
 
 struct BlobProto;
 
+struct MemoryPlan;
+
+struct BlobAllocation;
+
 namespace EltwiseParameter_ {
 
 enum EltwiseOp {
@@ -262,7 +266,8 @@ struct NetParameter FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
     VT_NAME = 4,
     VT_INPUT = 6,
     VT_INPUT_SHAPE = 8,
-    VT_LAYER = 10
+    VT_LAYER = 10,
+    VT_MEMORY_PLAN = 12
   };
   const flatbuffers::String *name() const {
     return GetPointer<const flatbuffers::String *>(VT_NAME);
@@ -276,6 +281,9 @@ struct NetParameter FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
   const flatbuffers::Vector<flatbuffers::Offset<LayerParameter>> *layer() const {
     return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<LayerParameter>> *>(VT_LAYER);
   }
+  const MemoryPlan *memory_plan() const {
+    return GetPointer<const MemoryPlan *>(VT_MEMORY_PLAN);
+  }
   bool Verify(flatbuffers::Verifier &verifier) const {
     return VerifyTableStart(verifier) &&
            VerifyOffset(verifier, VT_NAME) &&
@@ -289,6 +297,8 @@ struct NetParameter FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
            VerifyOffset(verifier, VT_LAYER) &&
            verifier.Verify(layer()) &&
            verifier.VerifyVectorOfTables(layer()) &&
+           VerifyOffset(verifier, VT_MEMORY_PLAN) &&
+           verifier.VerifyTable(memory_plan()) &&
            verifier.EndTable();
   }
 };
@@ -308,6 +318,9 @@ struct NetParameterBuilder {
   void add_layer(flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<LayerParameter>>> layer) {
     fbb_.AddOffset(NetParameter::VT_LAYER, layer);
   }
+  void add_memory_plan(flatbuffers::Offset<MemoryPlan> memory_plan) {
+    fbb_.AddOffset(NetParameter::VT_MEMORY_PLAN, memory_plan);
+  }
   explicit NetParameterBuilder(flatbuffers::FlatBufferBuilder &_fbb)
         : fbb_(_fbb) {
     start_ = fbb_.StartTable();
@@ -325,8 +338,10 @@ inline flatbuffers::Offset<NetParameter> CreateNetParameter(
     flatbuffers::Offset<flatbuffers::String> name = 0,
     flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>>> input = 0,
     flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<BlobShape>>> input_shape = 0,
-    flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<LayerParameter>>> layer = 0) {
+    flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<LayerParameter>>> layer = 0,
+    flatbuffers::Offset<MemoryPlan> memory_plan = 0) {
   NetParameterBuilder builder_(_fbb);
+  builder_.add_memory_plan(memory_plan);
   builder_.add_layer(layer);
   builder_.add_input_shape(input_shape);
   builder_.add_input(input);
@@ -339,13 +354,15 @@ inline flatbuffers::Offset<NetParameter> CreateNetParameterDirect(
     const char *name = nullptr,
     const std::vector<flatbuffers::Offset<flatbuffers::String>> *input = nullptr,
     const std::vector<flatbuffers::Offset<BlobShape>> *input_shape = nullptr,
-    const std::vector<flatbuffers::Offset<LayerParameter>> *layer = nullptr) {
+    const std::vector<flatbuffers::Offset<LayerParameter>> *layer = nullptr,
+    flatbuffers::Offset<MemoryPlan> memory_plan = 0) {
   return feather::CreateNetParameter(
       _fbb,
       name ? _fbb.CreateString(name) : 0,
       input ? _fbb.CreateVector<flatbuffers::Offset<flatbuffers::String>>(*input) : 0,
       input_shape ? _fbb.CreateVector<flatbuffers::Offset<BlobShape>>(*input_shape) : 0,
-      layer ? _fbb.CreateVector<flatbuffers::Offset<LayerParameter>>(*layer) : 0);
+      layer ? _fbb.CreateVector<flatbuffers::Offset<LayerParameter>>(*layer) : 0,
+      memory_plan);
 }
 
 struct InputParameter FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
@@ -3241,6 +3258,165 @@ inline flatbuffers::Offset<BlobProto> CreateBlobProtoDirect(
       width);
 }
 
+struct MemoryPlan FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  enum {
+    VT_BLOB = 4,
+    VT_ACTIVATION_SIZE = 6,
+    VT_SCRATCH_SIZE = 8
+  };
+  const flatbuffers::Vector<flatbuffers::Offset<BlobAllocation>> *blob() const {
+    return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<BlobAllocation>> *>(VT_BLOB);
+  }
+  uint64_t activation_size() const {
+    return GetField<uint64_t>(VT_ACTIVATION_SIZE, 0);
+  }
+  uint64_t scratch_size() const {
+    return GetField<uint64_t>(VT_SCRATCH_SIZE, 0);
+  }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyOffset(verifier, VT_BLOB) &&
+           verifier.Verify(blob()) &&
+           verifier.VerifyVectorOfTables(blob()) &&
+           VerifyField<uint64_t>(verifier, VT_ACTIVATION_SIZE) &&
+           VerifyField<uint64_t>(verifier, VT_SCRATCH_SIZE) &&
+           verifier.EndTable();
+  }
+};
+
+struct MemoryPlanBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_blob(flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<BlobAllocation>>> blob) {
+    fbb_.AddOffset(MemoryPlan::VT_BLOB, blob);
+  }
+  void add_activation_size(uint64_t activation_size) {
+    fbb_.AddElement<uint64_t>(MemoryPlan::VT_ACTIVATION_SIZE, activation_size, 0);
+  }
+  void add_scratch_size(uint64_t scratch_size) {
+    fbb_.AddElement<uint64_t>(MemoryPlan::VT_SCRATCH_SIZE, scratch_size, 0);
+  }
+  explicit MemoryPlanBuilder(flatbuffers::FlatBufferBuilder &_fbb)
+        : fbb_(_fbb) {
+    start_ = fbb_.StartTable();
+  }
+  MemoryPlanBuilder &operator=(const MemoryPlanBuilder &);
+  flatbuffers::Offset<MemoryPlan> Finish() {
+    const auto end = fbb_.EndTable(start_);
+    auto o = flatbuffers::Offset<MemoryPlan>(end);
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<MemoryPlan> CreateMemoryPlan(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<BlobAllocation>>> blob = 0,
+    uint64_t activation_size = 0,
+    uint64_t scratch_size = 0) {
+  MemoryPlanBuilder builder_(_fbb);
+  builder_.add_scratch_size(scratch_size);
+  builder_.add_activation_size(activation_size);
+  builder_.add_blob(blob);
+  return builder_.Finish();
+}
+
+inline flatbuffers::Offset<MemoryPlan> CreateMemoryPlanDirect(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    const std::vector<flatbuffers::Offset<BlobAllocation>> *blob = nullptr,
+    uint64_t activation_size = 0,
+    uint64_t scratch_size = 0) {
+  return feather::CreateMemoryPlan(
+      _fbb,
+      blob ? _fbb.CreateVector<flatbuffers::Offset<BlobAllocation>>(*blob) : 0,
+      activation_size,
+      scratch_size);
+}
+
+struct BlobAllocation FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  enum {
+    VT_LAYER = 4,
+    VT_TOP = 6,
+    VT_OFFSET = 8,
+    VT_SIZE = 10
+  };
+  const flatbuffers::String *layer() const {
+    return GetPointer<const flatbuffers::String *>(VT_LAYER);
+  }
+  uint32_t top() const {
+    return GetField<uint32_t>(VT_TOP, 0);
+  }
+  uint64_t offset() const {
+    return GetField<uint64_t>(VT_OFFSET, 0);
+  }
+  uint64_t size() const {
+    return GetField<uint64_t>(VT_SIZE, 0);
+  }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyOffset(verifier, VT_LAYER) &&
+           verifier.Verify(layer()) &&
+           VerifyField<uint32_t>(verifier, VT_TOP) &&
+           VerifyField<uint64_t>(verifier, VT_OFFSET) &&
+           VerifyField<uint64_t>(verifier, VT_SIZE) &&
+           verifier.EndTable();
+  }
+};
+
+struct BlobAllocationBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_layer(flatbuffers::Offset<flatbuffers::String> layer) {
+    fbb_.AddOffset(BlobAllocation::VT_LAYER, layer);
+  }
+  void add_top(uint32_t top) {
+    fbb_.AddElement<uint32_t>(BlobAllocation::VT_TOP, top, 0);
+  }
+  void add_offset(uint64_t offset) {
+    fbb_.AddElement<uint64_t>(BlobAllocation::VT_OFFSET, offset, 0);
+  }
+  void add_size(uint64_t size) {
+    fbb_.AddElement<uint64_t>(BlobAllocation::VT_SIZE, size, 0);
+  }
+  explicit BlobAllocationBuilder(flatbuffers::FlatBufferBuilder &_fbb)
+        : fbb_(_fbb) {
+    start_ = fbb_.StartTable();
+  }
+  BlobAllocationBuilder &operator=(const BlobAllocationBuilder &);
+  flatbuffers::Offset<BlobAllocation> Finish() {
+    const auto end = fbb_.EndTable(start_);
+    auto o = flatbuffers::Offset<BlobAllocation>(end);
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<BlobAllocation> CreateBlobAllocation(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    flatbuffers::Offset<flatbuffers::String> layer = 0,
+    uint32_t top = 0,
+    uint64_t offset = 0,
+    uint64_t size = 0) {
+  BlobAllocationBuilder builder_(_fbb);
+  builder_.add_size(size);
+  builder_.add_offset(offset);
+  builder_.add_top(top);
+  builder_.add_layer(layer);
+  return builder_.Finish();
+}
+
+inline flatbuffers::Offset<BlobAllocation> CreateBlobAllocationDirect(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    const char *layer = nullptr,
+    uint32_t top = 0,
+    uint64_t offset = 0,
+    uint64_t size = 0) {
+  return feather::CreateBlobAllocation(
+      _fbb,
+      layer ? _fbb.CreateString(layer) : 0,
+      top,
+      offset,
+      size);
+}
+
 inline const feather::NetParameter *GetNetParameter(const void *buf) {
   return flatbuffers::GetRoot<feather::NetParameter>(buf);
 }
@@ -46,6 +46,16 @@ Layer::Layer(const void* layer_param_in, const RuntimeParameter<float>* rt_param
     }
 }
 
+Layer::Layer(const std::string &name, const std::string &type, const RuntimeParameter<float>* rt_param)
+    : _name(name),
+      _type(type),
+      _fusible(false),
+      _inplace(false),
+      num_threads(rt_param->num_threads()),
+      common_mempool(rt_param->common_mempool())
+{
+}
+
 Layer::~Layer()
 {
     if(!_inplace){
@@ -141,6 +151,10 @@ int Layer::ForwardReshape()
     this->Forward();
     return true;
 }
+bool Layer::SupportsPackedLayout()
+{
+    return false;
+}
 std::string Layer::name()
 {
     return _name;
@@ -181,6 +195,42 @@ const Blob<float>* Layer::top_blob(size_t idx)
     std::string name = this->top(idx);
     return top_blob(name);
 }
+const Blob<float>* Layer::bottom_blob(size_t idx)
+{
+    std::string name = this->bottom(idx);
+    if (_bottom_blobs.find(name) != _bottom_blobs.end())
+        return _bottom_blobs[name];
+    else
+        return NULL;
+}
+void Layer::SetTopLayout(BlobLayout layout)
+{
+    for (int i = 0; i < _top.size(); ++i)
+    {
+        Blob<float>* p_blob = _top_blobs[_top[i]];
+        p_blob->Free();
+        p_blob->set_layout(layout);
+        p_blob->Alloc();
+    }
+}
+void Layer::TakeOverTop(Layer *next_layer)
+{
+    Blob<float> *p_blob = _top_blobs[_top[0]];
+    _top_blobs.erase(_top[0]);
+    _top[0] = next_layer->top(0);
+    _top_blobs[_top[0]] = p_blob;
+    p_blob->Free();
+    p_blob->CopyShape(next_layer->top_blob(0));
+    p_blob->Alloc();
+}
+void Layer::SetNumThreads(size_t threads)
+{
+    num_threads = threads;
+}
+void Layer::SetCommonMemPool(CommonMemPool<float> *pool)
+{
+    common_mempool = pool;
+}
 const size_t Layer::weight_blob_num() const
 {
     return _weight_blobs.size();
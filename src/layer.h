@@ -30,6 +30,7 @@ class Layer
 {
     public:
         Layer(const void* layer_param, const RuntimeParameter<float>* rt_param);//Layer param must be LayerParameter type
+        Layer(const std::string &name, const std::string &type, const RuntimeParameter<float>* rt_param);//For layers inserted by the net
         ~Layer();
         int SetupBottomBlob(const Blob<float>* p_blob, std::string name);
 
@@ -48,6 +49,9 @@ class Layer
         
         virtual int ForwardReshape();
 
+        //Whether the layer also runs on NC4HW4 bottoms, producing NC4HW4 tops. Asked after GenerateTopBlobs.
+        virtual bool SupportsPackedLayout();
+
         std::string name();
         std::string type();
         std::string bottom(size_t i);
@@ -57,11 +61,20 @@ class Layer
         size_t top_blob_size();
         const Blob<float>* top_blob(std::string name);
         const Blob<float>* top_blob(size_t idx);
+        const Blob<float>* bottom_blob(size_t idx);
+        //Reallocates the top blobs in the given layout.
+        void SetTopLayout(BlobLayout layout);
+        //Threads and scratch pool the layer runs with, set by the net before Init.
+        void SetNumThreads(size_t threads);
+        void SetCommonMemPool(CommonMemPool<float> *pool);
         //For fusing
         const size_t weight_blob_num() const;
         const Blob<float>* weight_blob(size_t i) const;
         bool fusible() const;
     protected:
+        //Renames and reshapes the top blob to the one of an absorbed layer, so that the net keeps exposing it.
+        void TakeOverTop(Layer *next_layer);
+
         std::string _name;
         std::string _type;
 
@@ -22,7 +22,11 @@
 #include "layers/conv_depthwise_layer.h"
 #include "layers/conv_im2col_layer.h"
 #include "layers/conv_winograd_layer.h"
+#include "layers/conv_winograd_decomposed_layer.h"
+#include "layers/conv_winograd_dilated_layer.h"
+#include "layers/conv_winogradF43_layer.h"
 #include "layers/conv_winogradF63_layer.h"
+#include "layers/deconv_layer.h"
 #include "layers/dropout_layer.h"
 #include "layers/batchnorm_layer.h"
 #include "layers/lrn_layer.h"
@@ -36,9 +40,12 @@
 #include "layers/reshape_layer.h"
 
 #include "layers/softmax_layer.h"
+#include "layers/argmax_layer.h"
 #include "layers/concat_layer.h"
 #include "layers/filter_layer.h"
 
+#include "arm/sparse.h"
+
 #include <stdio.h>
 
 namespace feather
@@ -47,6 +54,53 @@ Layer *GetInputLayer(const LayerParameter *layer_param, const RuntimeParameter<f
 {
     return (Layer *)new InputLayer(layer_param, rt_param);
 }
+//Bounds on the relative error of F(2x2,3x3), F(4x4,3x3) and F(6x6,3x3) measured on random data against a double precision reference.
+static const float kWinogradError[3] = {1e-6f, 2e-5f, 1e-4f};
+
+/*
+ * Output tile size of the Winograd variant for a 3x3 stride 1 convolution, 0 if none fits.
+ * Among the variants within the tolerance, the one multiplying the fewest transformed elements
+ * wins, ties go to the smaller and more accurate tile. Small or odd maps pad large tiles heavily.
+ */
+static size_t SelectWinogradTile(size_t input_channels, size_t output_channels, size_t output_height, size_t output_width, float tolerance)
+{
+    //All variants work on blocks of 4 output channels.
+    if (output_channels % 4 != 0 || output_channels >= 1024)
+        return 0;
+    size_t best_tile = 0;
+    size_t best_cost = 0;
+    for (size_t v = 0; v < 3; ++v)
+    {
+        const size_t tile = 2 * (v + 1);
+        if (kWinogradError[v] > tolerance || (tile == 2 && input_channels <= 4))
+            continue;
+        //Without the map size, take the largest tile allowed.
+        if (output_height == 0 || output_width == 0)
+        {
+            best_tile = tile;
+            continue;
+        }
+        size_t cost = ((output_height + tile - 1) / tile) * ((output_width + tile - 1) / tile) * (tile + 2) * (tile + 2);
+        if (best_tile == 0 || cost < best_cost)
+        {
+            best_tile = tile;
+            best_cost = cost;
+        }
+    }
+    return best_tile;
+}
+
+//Whether the weights of a convolution or inner product are sparse enough for the block sparse kernels.
+static bool UseSparseWeights(const LayerParameter *layer_param, const RuntimeParameter<float> * rt_param)
+{
+    const BlobProto *weights = layer_param->blobs()->Get(0);
+    const int M = weights->num();
+    if (M == 0 || rt_param->sparsity_threshold() > 1.f)
+        return false;
+    const int K = weights->data()->Length() / M;
+    return block_sparsity(weights->data()->data(), M, K) >= rt_param->sparsity_threshold();
+}
+
 Layer *GetConvolutionLayer(const LayerParameter *layer_param, const RuntimeParameter<float> * rt_param)
 {
     const ConvolutionParameter *conv_param = layer_param->convolution_param();
@@ -55,21 +109,86 @@ Layer *GetConvolutionLayer(const LayerParameter *layer_param, const RuntimeParam
     size_t kernel_width = conv_param->kernel_w();
     size_t stride_height = conv_param->stride_h();
     size_t stride_width = conv_param->stride_w();
+    stride_height = (stride_height == 0) ? 1 : stride_height;
+    stride_width = (stride_width == 0) ? 1 : stride_width;
+    size_t dilation_height, dilation_width;
+    ConvLayer::ParseDilation(conv_param, &dilation_height, &dilation_width);
     size_t input_channels = layer_param->blobs()->Get(0)->channels();
     size_t output_channels = layer_param->blobs()->Get(0)->num();
     ConvLayer *conv_layer = NULL;
-    if (group == 1 && kernel_height == 3 && kernel_width == 3 && stride_height == 1 && stride_width == 1 && input_channels > 0 && output_channels < 1024)
-//    if(0)
+    size_t winograd_tile = 0;
+    size_t decomposed_tile = 0;
+    size_t dilated_tile = 0;
+    if (dilation_height > 1 || dilation_width > 1)
+    {
+        //Space to batch: each phase is a dense 3x3 convolution on a map about dilation times smaller.
+        if (group == 1 && kernel_height == 3 && kernel_width == 3 && stride_height == 1 && stride_width == 1 && input_channels > 0)
+        {
+            size_t output_height = 0;
+            size_t output_width = 0;
+            if (rt_param->bottom_height() && rt_param->bottom_width()
+                && rt_param->bottom_height() + 2 * conv_param->pad_h() > 2 * dilation_height && rt_param->bottom_width() + 2 * conv_param->pad_w() > 2 * dilation_width)
+            {
+                output_height = rt_param->bottom_height() + 2 * conv_param->pad_h() - 2 * dilation_height;
+                output_width = rt_param->bottom_width() + 2 * conv_param->pad_w() - 2 * dilation_width;
+                output_height = (output_height + dilation_height - 1) / dilation_height;
+                output_width = (output_width + dilation_width - 1) / dilation_width;
+            }
+            dilated_tile = SelectWinogradTile(input_channels, output_channels, output_height, output_width, rt_param->winograd_tolerance());
+            //F(2x2,3x3) is not wired up.
+            if (dilated_tile == 2)
+                dilated_tile = 0;
+        }
+    }
+    else if (group == 1 && kernel_height == 3 && kernel_width == 3 && stride_height == 1 && stride_width == 1 && input_channels > 0)
+    {
+        size_t output_height = rt_param->bottom_height() ? rt_param->bottom_height() + 2 * conv_param->pad_h() - 2 : 0;
+        size_t output_width = rt_param->bottom_width() ? rt_param->bottom_width() + 2 * conv_param->pad_w() - 2 : 0;
+        winograd_tile = SelectWinogradTile(input_channels, output_channels, output_height, output_width, rt_param->winograd_tolerance());
+    }
+    else if (group == 1 && input_channels > 0 && ConvWinogradDecomposedLayer::Supports(kernel_height, kernel_width, stride_height, stride_width))
+    {
+        //Pieces are zero padded 3x3 kernels over 4x the input channels.
+        size_t output_height = 0;
+        size_t output_width = 0;
+        if (rt_param->bottom_height() && rt_param->bottom_width())
+        {
+            output_height = (rt_param->bottom_height() + 2 * conv_param->pad_h() - kernel_height) / stride_height + 1;
+            output_width = (rt_param->bottom_width() + 2 * conv_param->pad_w() - kernel_width) / stride_width + 1;
+        }
+        decomposed_tile = SelectWinogradTile(4 * input_channels, output_channels, output_height, output_width, rt_param->winograd_tolerance());
+        //F(2x2,3x3) is not wired up. The four pieces must multiply less than the direct convolution,
+        //which 3x3 stride 2 only does on large maps.
+        if (decomposed_tile == 2)
+            decomposed_tile = 0;
+        else if (decomposed_tile != 0 && output_height != 0)
+        {
+            size_t m = decomposed_tile;
+            size_t cost = 4 * ((output_height + m - 1) / m) * ((output_width + m - 1) / m) * (m + 2) * (m + 2);
+            if (cost >= kernel_height * kernel_width * output_height * output_width)
+                decomposed_tile = 0;
+        }
+        else if (kernel_height == 3)
+            decomposed_tile = 0;
+    }
+    if (dilated_tile != 0)
+    {
+        conv_layer = (ConvLayer*) new ConvWinogradDilatedLayer(layer_param, rt_param, dilated_tile);
+    }
+    else if (decomposed_tile != 0)
+    {
+        conv_layer = (ConvLayer*) new ConvWinogradDecomposedLayer(layer_param, rt_param, decomposed_tile);
+    }
+    else if (winograd_tile == 6)
     {
 //	printf("F63\n");
-#if 0
-        conv_layer = (ConvLayer*) new ConvWinogradLayer(layer_param, rt_param);
-#else
         conv_layer = (ConvLayer*) new ConvWinogradF63Layer(layer_param, rt_param);
-#endif
     }
-    else if (group == 1 && kernel_height == 3 && kernel_width == 3 && stride_height == 1 && stride_width == 1 && input_channels > 4)
-//    if(0)
+    else if (winograd_tile == 4)
+    {
+        conv_layer = (ConvLayer*) new ConvWinogradF43Layer(layer_param, rt_param);
+    }
+    else if (winograd_tile == 2)
     {
 //	printf("F23\n");
         conv_layer = (ConvLayer*) new ConvWinogradLayer(layer_param, rt_param);
@@ -77,7 +196,7 @@ Layer *GetConvolutionLayer(const LayerParameter *layer_param, const RuntimeParam
     else if (group == 1)
     {
 //	printf("Im2col\n");
-        conv_layer = (ConvLayer*) new ConvIm2colLayer(layer_param, rt_param);
+        conv_layer = (ConvLayer*) new ConvIm2colLayer(layer_param, rt_param, UseSparseWeights(layer_param, rt_param));
     }
     else//Should be depthwise convolution layer.
     {
@@ -90,6 +209,10 @@ Layer *GetDepthwiseConvolutionLayer(const LayerParameter *layer_param, const Run
 {
     return (Layer *)new ConvDepthwiseLayer(layer_param, rt_param);
 }
+Layer *GetDeconvolutionLayer(const LayerParameter *layer_param, const RuntimeParameter<float> * rt_param)
+{
+    return (Layer *)new DeconvLayer(layer_param, rt_param);
+}
 Layer *GetBatchNormLayer(const LayerParameter *layer_param, const RuntimeParameter<float> * rt_param)
 {
     return (Layer *)new BatchNormLayer(layer_param, rt_param);
@@ -132,12 +255,17 @@ Layer *GetEltwiseLayer(const LayerParameter *layer_param, const RuntimeParameter
 }
 Layer *GetInnerProductLayer(const LayerParameter *layer_param, const RuntimeParameter<float> * rt_param)
 {
-    return (Layer *)new InnerProductLayer(layer_param, rt_param);
+    bool sparse = UseSparseWeights(layer_param, rt_param);
+    return (Layer *)new InnerProductLayer(layer_param, rt_param, sparse, !sparse && rt_param->int8_inner_product());
 }
 Layer *GetSoftmaxLayer(const LayerParameter *layer_param, const RuntimeParameter<float> * rt_param)
 {
     return (Layer *)new SoftmaxLayer(layer_param, rt_param);
 }
+Layer *GetArgMaxLayer(const LayerParameter *layer_param, const RuntimeParameter<float> * rt_param)
+{
+    return (Layer *)new ArgMaxLayer(layer_param, rt_param);
+}
 Layer *GetFilterLayer(const LayerParameter *layer_param, const RuntimeParameter<float> * rt_param)
 {
     return (Layer *)new FilterLayer(layer_param, rt_param);
@@ -153,6 +281,7 @@ void register_layer_creators()
     REGISTER_LAYER_CREATOR(Input, GetInputLayer);
     REGISTER_LAYER_CREATOR(Convolution, GetConvolutionLayer);
     REGISTER_LAYER_CREATOR(DepthwiseConvolution, GetDepthwiseConvolutionLayer);
+    REGISTER_LAYER_CREATOR(Deconvolution, GetDeconvolutionLayer);
     REGISTER_LAYER_CREATOR(BatchNorm, GetBatchNormLayer);
     REGISTER_LAYER_CREATOR(LRN, GetLRNLayer);
     REGISTER_LAYER_CREATOR(Concat, GetConcatLayer);
@@ -165,6 +294,7 @@ void register_layer_creators()
     REGISTER_LAYER_CREATOR(Eltwise, GetEltwiseLayer);
     REGISTER_LAYER_CREATOR(InnerProduct, GetInnerProductLayer);
     REGISTER_LAYER_CREATOR(Softmax, GetSoftmaxLayer);
+    REGISTER_LAYER_CREATOR(ArgMax, GetArgMaxLayer);
     REGISTER_LAYER_CREATOR(Filter, GetFilterLayer);
     REGISTER_LAYER_CREATOR(Reshape, GetReshapeLayer);
 }
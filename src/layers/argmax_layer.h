@@ -0,0 +1,131 @@
+//Tencent is pleased to support the open source community by making FeatherCNN available.
+
+//Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+
+//Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+//in compliance with the License. You may obtain a copy of the License at
+//
+//https://opensource.org/licenses/BSD-3-Clause
+//
+//Unless required by applicable law or agreed to in writing, software distributed
+//under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//CONDITIONS OF ANY KIND, either express or implied. See the License for the
+//specific language governing permissions and limitations under the License.
+
+#pragma once
+
+#include "../feather_simple_generated.h"
+#include "../layer.h"
+#include "softmax_layer.h"
+#include "arm/softmax.h"
+#include "arm/helper.h"
+
+namespace feather
+{
+/*
+ * Caffe's ArgMax. Axis 0 (the default, the batch is always 1) picks the top k over
+ * channels x height x width and writes the indices, followed by the values with out_max_val.
+ * Other axes replace that dimension by top_k and hold either the values or the indices.
+ */
+class ArgMaxLayer : public Layer
+{
+    public:
+        ArgMaxLayer(const LayerParameter* layer_param, const RuntimeParameter<float>* rt_param)
+            : top_k(1), out_max_val(false), axis(0), Layer(layer_param, rt_param)
+        {
+            const ArgMaxParameter* argmax_param = layer_param->argmax_param();
+            if (argmax_param)
+            {
+                top_k = argmax_param->top_k();
+                out_max_val = argmax_param->out_max_val();
+                axis = argmax_param->axis();
+            }
+            top_k = (top_k == 0) ? 1 : top_k;
+        }
+
+        //(num, channels, height, width) of the top blob.
+        static void TopShape(const Blob<float>* p_bottom, int axis, size_t top_k, bool out_max_val, size_t shape[4])
+        {
+            if (axis == 0)
+            {
+                shape[0] = p_bottom->num();
+                shape[1] = out_max_val ? 2 : 1;
+                shape[2] = top_k;
+                shape[3] = 1;
+                return;
+            }
+            shape[0] = p_bottom->num();
+            shape[1] = p_bottom->channels();
+            shape[2] = p_bottom->height();
+            shape[3] = p_bottom->width();
+            shape[(axis < 0) ? axis + 4 : axis] = top_k;
+        }
+
+        //Elements the top k are picked from, axis 0 reduces over channels x height x width.
+        static size_t ReducedSize(const Blob<float>* p_bottom, int axis)
+        {
+            size_t outer, n, inner;
+            SplitAtAxis(p_bottom, (axis == 0) ? 1 : axis, &outer, &n, &inner);
+            return (axis == 0) ? n * inner : n;
+        }
+
+        int GenerateTopBlobs()
+        {
+            const Blob<float>* p_bottom = _bottom_blobs[_bottom[0]];
+            const size_t n = ReducedSize(p_bottom, axis);
+            if (top_k > n)
+            {
+                LOGE("ArgMax %s: top_k %zu exceeds the %zu elements\n", _name.c_str(), top_k, n);
+                return -1;
+            }
+            size_t shape[4];
+            TopShape(p_bottom, axis, top_k, out_max_val, shape);
+            _top_blobs[_top[0]] = new Blob<float>(shape[0], shape[1], shape[2], shape[3]);
+            _top_blobs[_top[0]]->Alloc();
+            return 0;
+        }
+
+        int ForwardReshape()
+        {
+            const size_t n = ReducedSize(_bottom_blobs[_bottom[0]], axis);
+            if (top_k > n)
+            {
+                LOGE("ArgMax %s: top_k %zu exceeds the %zu elements\n", _name.c_str(), top_k, n);
+                return -1;
+            }
+            size_t shape[4];
+            TopShape(_bottom_blobs[_bottom[0]], axis, top_k, out_max_val, shape);
+            _top_blobs[_top[0]]->ReshapeWithRealloc(shape[0], shape[1], shape[2], shape[3]);
+            return Forward();
+        }
+
+        int Forward()
+        {
+            const Blob<float>* p_bottom = _bottom_blobs[_bottom[0]];
+            const float* input = p_bottom->data();
+            float* output = _top_blobs[_top[0]]->data();
+            size_t outer, n, inner;
+            if (is_flattened())
+            {
+                SplitAtAxis(p_bottom, 1, &outer, &n, &inner);
+                topk(output, out_max_val ? output + top_k : NULL, input, outer, n * inner, 1, top_k, false, num_threads);
+            }
+            else
+            {
+                SplitAtAxis(p_bottom, axis, &outer, &n, &inner);
+                topk(out_max_val ? NULL : output, out_max_val ? output : NULL, input, outer, n, inner, top_k, false, num_threads);
+            }
+            return 0;
+        }
+
+        bool is_flattened() const { return axis == 0; }
+        int reduce_axis() const { return axis; }
+        size_t k() const { return top_k; }
+        bool outputs_max_val() const { return out_max_val; }
+
+    private:
+        size_t top_k;
+        bool out_max_val;
+        int axis;
+};
+};
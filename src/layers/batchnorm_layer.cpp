@@ -21,9 +21,19 @@ namespace feather
 {
 int BatchNormLayer::Forward()
 {
-    const float* input = _bottom_blobs[_bottom[0]]->data();
+    const Blob<float> *p_blob = _bottom_blobs[_bottom[0]];
+    const float* input = p_blob->data();
     float* output = _top_blobs[_top[0]]->data();
-    size_t stride = input_width * input_height;
+    //Taken from the bottom blob so that ForwardReshape sees the new size.
+    size_t stride = p_blob->width() * p_blob->height();
+    if (packed_scale)
+    {
+        if (fuse_relu)
+            affine_nc4hw4<true>(input_channels, stride, packed_scale, packed_bias, input, output, num_threads);
+        else
+            affine_nc4hw4<false>(input_channels, stride, packed_scale, packed_bias, input, output, num_threads);
+        return 0;
+    }
     bn_kernel(input_channels, stride, alpha, beta, scale_bias_data, scale_data, input, output, num_threads);
     return 0;
 }
@@ -83,6 +93,30 @@ int BatchNormLayer::Init()
         else
             scale_bias_data = NULL;
     }
+    if (p_blob->layout() == NC4HW4)
+    {
+        size_t aligned_channels = p_blob->aligned_channels();
+        MEMPOOL_CHECK_RETURN(private_mempool.Alloc(&packed_scale, aligned_channels * sizeof(float)));
+        MEMPOOL_CHECK_RETURN(private_mempool.Alloc(&packed_bias, aligned_channels * sizeof(float)));
+        for (int i = 0; i < aligned_channels; i++)
+        {
+            float s = 0.f, b = 0.f;
+            if (i < input_channels)
+            {
+                s = beta[i];
+                b = alpha[i];
+                if (fuse_scale)
+                {
+                    s *= scale_data[i];
+                    b *= scale_data[i];
+                }
+                if (scale_bias_data)
+                    b += scale_bias_data[i];
+            }
+            packed_scale[i] = s;
+            packed_bias[i] = b;
+        }
+    }
     SetKernel();
     
     return 0;
@@ -33,6 +33,8 @@ class BatchNormLayer : Layer
               fuse_scale(false),
               scale_data(NULL),
               fuse_relu(false),
+              packed_scale(NULL),
+              packed_bias(NULL),
               Layer(layer_param, rt_param)
         {
             _fusible = true;
@@ -41,6 +43,10 @@ class BatchNormLayer : Layer
         int Init();
         int Forward();
         int Fuse(Layer *);
+        bool SupportsPackedLayout()
+        {
+            return true;
+        }
     private:
         size_t input_channels;
         size_t input_width;
@@ -54,6 +60,10 @@ class BatchNormLayer : Layer
         float* scale_bias_data;
         bool fuse_relu;
 
+        //Folded y = scale * x + bias for NC4HW4 inputs.
+        float* packed_scale;
+        float* packed_bias;
+
     private:
         int SetKernel();
         void (*bn_kernel)(const size_t channels, const size_t stride, const float* alpha, const float* beta, const float* bias_data, const float* scale_data, const float* input, float* output, const size_t num_threads);
@@ -63,10 +63,23 @@ int ConcatLayer::ForwardReshape()
         channels += p_blob->channels();
     }
     LOGI("Output shape %d %d %d\n", channels, height, width);
-    _top_blobs[_top[0]]->ReshapeWithRealloc(num, channels, width, height);
+    _top_blobs[_top[0]]->ReshapeWithRealloc(num, channels, height, width);
+    _top_ptr_table.clear();
+    this->Init();
     return this->Forward();
 }
 
+//NC4HW4 blobs concatenate block-wise as long as no bottom ends in a partial block.
+bool ConcatLayer::SupportsPackedLayout()
+{
+    for (int i = 0; i < _bottom.size(); ++i)
+    {
+        if (_bottom_blobs[_bottom[i]]->channels() % 4 != 0)
+            return false;
+    }
+    return true;
+}
+
 int ConcatLayer::Init()
 {
     float* top_data = _top_blobs[_top[0]]->data();
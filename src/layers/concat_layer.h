@@ -31,6 +31,7 @@ class ConcatLayer : public Layer
         int ForwardReshape();
         int Init();
         int GenerateTopBlobs();
+        bool SupportsPackedLayout();
     private:
         std::vector<float*> _top_ptr_table;
 };
@@ -18,9 +18,11 @@
 #include "../layer.h"
 #include "arm/generic_kernels.h"
 #include "arm/depthwise.h"
+#include "arm/sgemm.h"
 
 #include <assert.h>
 #include <stdio.h>
+#include <string.h>
 
 namespace feather
 {
@@ -28,25 +30,87 @@ class ConvDepthwiseLayer : public ConvLayer
 {
     public:
         ConvDepthwiseLayer(const LayerParameter *layer_param, const RuntimeParameter<float>* rt_param)
-            : ConvLayer(layer_param, rt_param)
+            : padded_input(NULL), padded_size(0), dw_relu(false), fuse_pw(false), pw_relu(false), pw_channels(0),
+              pw_kernel(NULL), pw_bias(NULL), pw_pack_array(NULL), pw_pack_size(0), pw_kc(320), pw_nc(160), packed_kernel(NULL), packed_bias(NULL), ConvLayer(layer_param, rt_param)
         {
             //From proto
+            _fusible = true;
+        }
+
+        bool SupportsPackedLayout()
+        {
+            return !fuse_pw && group == input_channels && group == output_channels && !IsGlobal();
         }
 
         int Init()
         {
-            int inputw = input_width + padding_left + padding_right;
-            int inputh = input_height + padding_top + padding_bottom;
-            MEMPOOL_CHECK_RETURN(private_mempool.Alloc(&padded_input, inputw * inputh * input_channels * sizeof(float)));
+            if (_bottom_blobs[_bottom[0]]->layout() == NC4HW4)
+                return InitPacked();
+            MEMPOOL_CHECK_RETURN(AllocPaddedInput());
+            if (fuse_pw)
+            {
+                MEMPOOL_CHECK_RETURN(AllocPointwisePackArray());
+                if (pw_bias && pw_relu)
+                    pw_sgemm = packed_sgemm_activation<true, true>;
+                else if (pw_bias)
+                    pw_sgemm = packed_sgemm_activation<true, false>;
+                else if (pw_relu)
+                    pw_sgemm = packed_sgemm_activation<false, true>;
+                else
+                    pw_sgemm = packed_sgemm_activation<false, false>;
+                MEMPOOL_CHECK_RETURN(common_mempool->Request(ScratchSize()));
+            }
             return 0;
         }
 
+        /*
+         * A following ReLU is applied in the output stage. A pointwise convolution consuming the
+         * depthwise output is absorbed as a whole: the block then runs band by band, so that the
+         * depthwise output only ever exists as a cache sized band feeding the 1x1 GEMM.
+         */
+        int Fuse(Layer *next_layer)
+        {
+            if (next_layer->type().compare("ReLU") == 0)
+            {
+                if (fuse_pw)
+                    pw_relu = true;
+                else
+                    dw_relu = true;
+                return 1;
+            }
+            if (fuse_pw || next_layer->type().compare("Convolution") != 0 || !((ConvLayer *) next_layer)->is_pointwise())
+                return 0;
+            if (group != input_channels || group != output_channels || IsGlobal())
+                return 0;
+            //The absorbed layer and its weights are released by the net, keep our own packed copy.
+            const Blob<float> *pw_weight = next_layer->weight_blob(0);
+            pw_channels = pw_weight->num();
+            int M = (int)pw_channels;
+            int K = (int)output_channels;
+            MEMPOOL_CHECK_RETURN(private_mempool.Alloc(&pw_kernel, sizeof(float) * M * K));
+            packed_sgemm_init<4>(M, K, pw_kc, pw_kernel, pw_weight->data(), K);
+            if (next_layer->weight_blob_num() > 1)
+            {
+                MEMPOOL_CHECK_RETURN(private_mempool.Alloc(&pw_bias, sizeof(float) * M));
+                memcpy(pw_bias, next_layer->weight_blob(1)->data(), sizeof(float) * M);
+            }
+            TakeOverTop(next_layer);
+            fuse_pw = true;
+            return 1;
+        }
+
         int Forward()
         {
             const float *input = _bottom_blobs[_bottom[0]]->data();
             float *output = _top_blobs[_top[0]]->data();
             int inputw = input_width + padding_left + padding_right;
             int inputh = input_height + padding_top + padding_bottom;
+            if (packed_kernel)
+            {
+                dwConvNC4HW4(output, input, output_channels, input_height, input_width, output_height, output_width, packed_kernel,
+                             kernel_height, kernel_width, stride_height, stride_width, dilation_height, dilation_width, padding_top, padding_left, packed_bias, dw_relu, num_threads);
+                return 0;
+            }
 /*
 	    printf("group %d %d %d %d %d %d %d %d\n", group, input_channels, input_height, input_width, padding_top, padding_bottom, padding_left, padding_right);
 	    printf("stride %d %d %d %d\n",  stride_width, stride_height, kernel_width, kernel_height);
@@ -65,32 +129,144 @@ class ConvDepthwiseLayer : public ConvLayer
 	    printf("====BIAS=========\n");
 */
 	   
-	    if(padding_left==0 && padding_right==0 && padding_top==0 && padding_bottom==0)	;
+	    float *dw_input = padded_input;
+	    if(padding_left==0 && padding_right==0 && padding_top==0 && padding_bottom==0)
+		dw_input = const_cast<float *>(input);
 	    else 
 	    	pad_input(padded_input, input, input_channels, input_width, input_height, padding_left, padding_top, padding_right, padding_bottom);
+
+	    if (fuse_pw)
+		return ForwardPointwise(output, dw_input, inputw, inputh);
 	    
-	    if(inputw==kernel_width && inputh==kernel_height)
+	    if(IsGlobal())
+	    {
             	globalDwConv(output, input, input_channels, inputw, inputh, kernel_data, group, num_threads);
-	    else 	
-            	dwConv(output, padded_input, inputw, inputh, stride_width, stride_height, kernel_data, kernel_width, kernel_height, group, num_threads);
-
-            if (bias_term)
-            {
-                size_t out_stride = output_width * output_height;
-                for (int i = 0; i < output_channels; ++i)
+                if (bias_term || dw_relu)
                 {
-                    float bias = bias_data[i];
-                    for (int j = 0; j < out_stride; ++j)
+                    for (int i = 0; i < output_channels; ++i)
                     {
-                        output[out_stride * i + j] = output[out_stride * i + j] + bias;
+                        float v = output[i] + (bias_term ? bias_data[i] : 0.f);
+                        output[i] = (dw_relu && v < 0.f) ? 0.f : v;
                     }
                 }
-            }
+	    }
+	    else
+            	dwConvRows(output, dw_input, output_channels, inputw, inputw * inputh, stride_width, stride_height, kernel_data,
+                           kernel_width, kernel_height, dilation_width, dilation_height, output_width, 0, output_height, bias_term ? bias_data : NULL, dw_relu, num_threads);
             return 0;
         }
 
+        int ForwardReshape()
+        {
+            const Blob<float> *bottom_blob = _bottom_blobs[_bottom[0]];
+            input_height    = bottom_blob->height();
+            input_width     = bottom_blob->width();
+
+            output_width  = (input_width + padding_left + padding_right - kernel_extent_w()) / stride_width + 1;
+            output_height = (input_height + padding_top + padding_bottom - kernel_extent_h()) / stride_height + 1;
+
+            _top_blobs[_top[0]]->ReshapeWithRealloc(1, fuse_pw ? pw_channels : output_channels, output_height, output_width);
+            if (!packed_kernel)
+                MEMPOOL_CHECK_RETURN(AllocPaddedInput());
+            if (fuse_pw)
+                MEMPOOL_CHECK_RETURN(common_mempool->Alloc(ScratchSize()));
+            return this->Forward();
+        }
+
     private:
+        bool IsGlobal()
+        {
+            return dilation_width == 1 && dilation_height == 1
+                   && kernel_width == input_width + padding_left + padding_right && kernel_height == input_height + padding_top + padding_bottom;
+        }
+
+        //Kernel as [channels / 4][kh * kw][4] with zero padded channels, pads are handled by the kernel.
+        int InitPacked()
+        {
+            const size_t blocks = (output_channels + 3) / 4;
+            const size_t kernel_size = kernel_width * kernel_height;
+            MEMPOOL_CHECK_RETURN(private_mempool.Alloc(&packed_kernel, blocks * kernel_size * 4 * sizeof(float)));
+            MEMPOOL_CHECK_RETURN(private_mempool.Alloc(&packed_bias, blocks * 4 * sizeof(float)));
+            for (size_t c = 0; c < blocks * 4; ++c)
+            {
+                for (size_t k = 0; k < kernel_size; ++k)
+                    packed_kernel[((c / 4) * kernel_size + k) * 4 + c % 4] = (c < output_channels) ? kernel_data[c * kernel_size + k] : 0.f;
+                packed_bias[c] = (c < output_channels && bias_term) ? bias_data[c] : 0.f;
+            }
+            return 0;
+        }
+
+        bool AllocPaddedInput()
+        {
+            size_t inputw = input_width + padding_left + padding_right;
+            size_t inputh = input_height + padding_top + padding_bottom;
+            size_t size = inputw * inputh * input_channels;
+            if (size <= padded_size)
+                return true;
+            if (padded_input)
+                private_mempool.Free(&padded_input);
+            padded_size = size;
+            return private_mempool.Alloc(&padded_input, size * sizeof(float));
+        }
+
+        //A GEMM panel per thread for the fused pointwise conv, grown when the layer gets more threads.
+        bool AllocPointwisePackArray()
+        {
+            size_t size = (pw_kc + 8) * pw_nc * num_threads;
+            if (size <= pw_pack_size)
+                return true;
+            if (pw_pack_array)
+                private_mempool.Free(&pw_pack_array);
+            pw_pack_size = size;
+            return private_mempool.Alloc(&pw_pack_array, size * sizeof(float));
+        }
+
+        //Scratch holds a depthwise output band.
+        size_t ScratchSize()
+        {
+            //Aim at ~128KB of depthwise output per band.
+            band_rows = 32 * 1024 / (output_channels * output_width);
+            band_rows = (band_rows < 1) ? 1 : band_rows;
+            band_rows = (band_rows > output_height) ? output_height : band_rows;
+            return sizeof(float) * output_channels * band_rows * output_width;
+        }
+
+        int ForwardPointwise(float *output, const float *dw_input, int inputw, int inputh)
+        {
+            float *dw_buffer = NULL;
+            MEMPOOL_CHECK_RETURN(common_mempool->GetPtr(&dw_buffer));
+            MEMPOOL_CHECK_RETURN(AllocPointwisePackArray());
+            const int M = pw_channels;
+            const int K = output_channels;
+            const size_t out_stride = output_width * output_height;
+            for (size_t row_begin = 0; row_begin < output_height; row_begin += band_rows)
+            {
+                size_t row_end = (row_begin + band_rows < output_height) ? row_begin + band_rows : output_height;
+                const int N = (row_end - row_begin) * output_width;
+                dwConvRows(dw_buffer, dw_input, output_channels, inputw, inputw * inputh, stride_width, stride_height, kernel_data,
+                           kernel_width, kernel_height, dilation_width, dilation_height, output_width, row_begin, row_end, bias_term ? bias_data : NULL, dw_relu, num_threads);
+                //The band rows of all output channels are written in place, with bias and ReLU fused.
+                pw_sgemm(M, N, K, pw_kernel, dw_buffer, N, output + row_begin * output_width, out_stride, pw_nc, pw_kc, pw_bias, num_threads, pw_pack_array);
+            }
+            return 0;
+        }
+
         float* padded_input;
+        size_t padded_size;
+        bool dw_relu;
+
+        bool fuse_pw;
+        bool pw_relu;
+        size_t pw_channels;
+        size_t band_rows;
+        float* pw_kernel;
+        float* pw_bias;
+        float* pw_pack_array;
+        size_t pw_pack_size;
+        int pw_kc, pw_nc;
+        void (*pw_sgemm)(int M, int N, int K, float *packA, float *b, int ldb, float *c, int ldc, int nc, int kc, float* bias, int num_threads, float* pack_array);
 
+        float* packed_kernel;
+        float* packed_bias;
 };
 };
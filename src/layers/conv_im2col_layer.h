@@ -20,15 +20,13 @@
 
 #include "arm/generic_kernels.h"
 #include "arm/sgemm.h"
-#include "arm/sgemm_legacy.h"
+#include "arm/sparse.h"
 #include "arm/helper.h"
 
 #include <assert.h>
 #include <stdio.h>
 
 
-#define USE_LEGACY_SGEMM
-
 namespace feather
 {
 void naive_sgemm(int M, int N, int L, float* A, float* B, float* C)
@@ -46,17 +44,17 @@ void naive_sgemm(int M, int N, int L, float* A, float* B, float* C)
         }
     }
 }
+/*
+ * Convolution as im2col followed by a packed GEMM. With sparse set the weights are kept as
+ * 4x1 blocks and the GEMM skips the zero ones.
+ */
 class ConvIm2colLayer : public ConvLayer
 {
     public:
-        ConvIm2colLayer(const LayerParameter *layer_param, const RuntimeParameter<float>* rt_param)
-            : fuse_relu(false), kc(0), nc(0), img_buffer(0), pack_array_size(0), ConvLayer(layer_param, rt_param)
+        ConvIm2colLayer(const LayerParameter *layer_param, const RuntimeParameter<float>* rt_param, bool sparse = false)
+            : fuse_relu(false), sparse(sparse), kc(0), nc(0), img_buffer(0), pack_array_size(0), ConvLayer(layer_param, rt_param)
         {
-#ifdef USE_LEGACY_SGEMM
-		_fusible = false;
-#else
 		_fusible = true;
-#endif
 		//kc = 304;
 		//nc = 304;
 		kc = 320;
@@ -68,101 +66,85 @@ class ConvIm2colLayer : public ConvLayer
 
         int Forward()
         {
-            //MEMPOOL_CHECK_RETURN(common_mempool->GetPtr(&pack_array));
-	    //img_buffer = pack_array + pack_array_size;
-            MEMPOOL_CHECK_RETURN(common_mempool->GetPtr(&img_buffer));
-	    if(group <=0)	group = 1;
-#ifdef USE_LEGACY_SGEMM
-#if 1
-	    if (kernel_width == 1 && kernel_height == 1 && stride_height == 1 && stride_width == 1 && padding_left == 1 && padding_right == 1 && padding_top == 1 && padding_bottom == 1)
+            if (!sparse)
+                MEMPOOL_CHECK_RETURN(AllocPackArray());
+            if (fuse_pool)
+                return ForwardPooled();
+            const int M = output_channels;
+            const int N = output_height * output_width;
+            const int K = input_channels * kernel_width * kernel_height;
+            //A pointwise conv reads the input as is, no unrolling needed.
+            if (is_pointwise())
             {
-                if (output_channels % 8 == 0)
-                {
-                    block_sgemm_external_pack_threading_8x8((int)output_channels, (int)output_width * (int)output_height,
-                                                            (int)input_channels * (int)kernel_width * (int)kernel_height,
-                                                            packed_kernel, input, output, (int)num_threads);
-                }
-                else
-                {
-                    block_sgemm_external_pack_threading((int)output_channels, (int)output_width * (int)output_height,
-                                                        (int)input_channels * (int)kernel_width * (int)kernel_height,
-                                                        packed_kernel, input, output, (int)num_threads);
-                }
+                Gemm(N, input, output);
+                return 0;
             }
-            else
+            //Strided ones gather their columns while packing B.
+            if (is_unpadded_1x1() && !sparse)
             {
-                Im2col();
-
-                //jintaomeng  support the case for group != input_channels
-                int block = (int)input_channels / group * (int)kernel_width * (int)kernel_height;
-                if (output_channels % 8 == 0)
-                {
-                    for (int k = 0; k < group; k++)
-                        block_sgemm_external_pack_threading_8x8((int)output_channels, (int)output_width * (int)output_height,
-                                                                (int)input_channels / group * (int)kernel_width * (int)kernel_height,
-                                                                packed_kernel, img_buffer + k * block, output, (int)num_threads);
-                }
-                else
-                {
-
-                    for (int k = 0; k < group; k++)
-                        block_sgemm_external_pack_threading((int)output_channels, (int)output_width * (int)output_height,
-                                                            (int)input_channels / group * (int)kernel_width * (int)kernel_height,
-                                                            packed_kernel, img_buffer + k * block, output, (int)num_threads);
-                }
+                packed_sgemm_strided(M, N, K, packed_kernel, input, input_height * input_width, output_width, input_width, stride_width, output, N, nc, kc, bias_data, num_threads, pack_array);
+                return 0;
             }
-#else
-            Im2col();
-            naive_sgemm(output_channels, output_height * output_width, input_channels * kernel_width * kernel_height, kernel_data, img_buffer, output);
-#endif
-            if (bias_term)
+            MEMPOOL_CHECK_RETURN(common_mempool->GetPtr(&img_buffer));
+            Im2col(0, output_height);
+            Gemm(N, img_buffer, output);
+            return 0;
+        }
+
+        //Runs im2col and GEMM band by band and pools each band straight into the top blob.
+        int ForwardPooled()
+        {
+            MEMPOOL_CHECK_RETURN(common_mempool->GetPtr(&img_buffer));
+            const int K = input_channels * kernel_width * kernel_height;
+            float *band_output = img_buffer + K * conv_band_rows * output_width;
+            for (size_t pr = 0; pr < pooled_height; pr += pool_band_rows)
             {
-                size_t out_stride = output_width * output_height;
-                for (int i = 0; i < output_channels; ++i)
+                size_t pr_end = (pr + pool_band_rows < pooled_height) ? pr + pool_band_rows : pooled_height;
+                size_t row_begin = PoolBandBegin(pr);
+                size_t row_end = PoolBandEnd(pr_end);
+                if (row_end > row_begin)
                 {
-                    float bias = bias_data[i];
-                    for (int j = 0; j < out_stride; ++j)
-                    {
-                        output[out_stride * i + j] = output[out_stride * i + j] + bias;
-                    }
+                    const int N = (row_end - row_begin) * output_width;
+                    Im2col(row_begin, row_end);
+                    Gemm(N, img_buffer, band_output);
                 }
+                PoolBand(output, band_output, row_begin, row_end, pr, pr_end);
             }
-#else
-	    const int M = output_channels;
-	    const int N = output_height * output_width;
-	    const int K = input_channels * kernel_width * kernel_height;
-	    if (kernel_width == 1 && kernel_height == 1 && stride_height == 1 && stride_width == 1 && padding_left == 1 && padding_right == 1 && padding_top == 1 && padding_bottom == 1)
-	    {
-	          packed_sgemm(M, N, K, packed_kernel, input, N, output, N, nc, kc, bias_data, num_threads, pack_array);
-	    }
-	    else
-	    {
-	          Im2col();
-	          packed_sgemm(M, N, K, packed_kernel, img_buffer, N, output, N, nc, kc, bias_data, num_threads, pack_array);
-	    }
-#endif
             return 0;
         }
 
+        size_t ScratchSize()
+        {
+            const size_t K = input_channels * kernel_height * kernel_width;
+            if (!fuse_pool)
+                return (is_pointwise() || (is_unpadded_1x1() && !sparse)) ? 0 : sizeof(float) * K * (output_width * output_height);
+            //Aim at ~256KB of conv output per band.
+            SetupPoolBands(256 * 1024 / (sizeof(float) * output_channels * output_width));
+            return sizeof(float) * (K + output_channels) * conv_band_rows * output_width;
+        }
+
         virtual int ForwardReshape()
         {
             const Blob<float> *bottom_blob = _bottom_blobs[_bottom[0]];
             input_height    = bottom_blob->height();
             input_width     = bottom_blob->width();
 
-            output_width  = (input_width + padding_left + padding_right - kernel_width) / stride_width + 1;
-            output_height = (input_height + padding_top + padding_bottom - kernel_height) / stride_height + 1;
+            output_width  = (input_width + padding_left + padding_right - kernel_extent_w()) / stride_width + 1;
+            output_height = (input_height + padding_top + padding_bottom - kernel_extent_h()) / stride_height + 1;
             
-#ifdef USE_LEGACY_SGEMM
-            int M = (int)output_channels;
-            int eM = M + (8 - M % 8) % 8;
-            _top_blobs[_top[0]]->Realloc(eM * output_height * output_width);
-#endif
-            //Global memory allocations
-            _top_blobs[_top[0]]->ReshapeWithRealloc(1, output_channels, output_height, output_width);
+            if (fuse_pool)
+            {
+                UpdatePooledShape();
+                _top_blobs[_top[0]]->ReshapeWithRealloc(1, output_channels, pooled_height, pooled_width);
+            }
+            else
+            {
+                //Global memory allocations
+                _top_blobs[_top[0]]->ReshapeWithRealloc(1, output_channels, output_height, output_width);
+            }
             input = _bottom_blobs[_bottom[0]]->data();
             output = _top_blobs[_top[0]]->data();
-            MEMPOOL_CHECK_RETURN(common_mempool->Alloc(sizeof(float) * (input_channels * kernel_height * kernel_width) * (output_width * output_height)))
+            MEMPOOL_CHECK_RETURN(common_mempool->Alloc(ScratchSize()))
 
             return this->Forward();
         }
@@ -180,8 +162,8 @@ class ConvIm2colLayer : public ConvLayer
                 stride_width = 1;
                 stride_height = 1;
             }
-            output_width = (input_width + padding_left + padding_right - kernel_width) / stride_width + 1;
-            output_height = (input_height + padding_top + padding_bottom - kernel_height) / stride_height + 1;
+            output_width = (input_width + padding_left + padding_right - kernel_extent_w()) / stride_width + 1;
+            output_height = (input_height + padding_top + padding_bottom - kernel_extent_h()) / stride_height + 1;
 #if 0
             printf("input channels %d\n", input_channels);
             assert(input_channels == bottom_blob->channels());
@@ -194,11 +176,6 @@ class ConvIm2colLayer : public ConvLayer
 #endif
             _top_blobs[_top[0]] = new Blob<float>(1, output_channels, output_height, output_width);
             _top_blobs[_top[0]]->Alloc();
-            int M = output_channels;
-#ifdef USE_LEGACY_SGEMM
-            int eM = M + (8 - M % 8) % 8;
-            _top_blobs[_top[0]]->Realloc(eM * output_height * output_width);
-#endif
             return 0;
         }
 
@@ -206,18 +183,23 @@ class ConvIm2colLayer : public ConvLayer
         {
             if (next_layer->type().compare("ReLU") == 0)
             {
+                //ReLU commutes with max pooling only.
+                if (fuse_pool && !pool_max)
+                    return 0;
                 fuse_relu = true;
                 return 1;
             }
             else
             {
-                return 0;
+                return FusePooling(next_layer);
             }
         }
 
-        bool Im2col()
+        //Unrolls conv output rows [row_begin, row_end) into img_buffer.
+        bool Im2col(size_t row_begin, size_t row_end)
         {
-            const int stride = kernel_height * kernel_width * output_height * output_width;
+            const int rows = row_end - row_begin;
+            const int stride = kernel_height * kernel_width * rows * output_width;
             if ((kernel_width == 1 && kernel_height == 1) && (stride_height == 2 && stride_width == 2))
             {
                 float* ret = img_buffer;
@@ -226,7 +208,7 @@ class ConvIm2colLayer : public ConvLayer
                 {
                     int retID = stride * k;
                     {
-                        for (int i = 0; i < output_height; i++)
+                        for (int i = row_begin; i < row_end; i++)
                         {
                             for (int j = 0; j < output_width; j++)
                             {
@@ -258,13 +240,13 @@ class ConvIm2colLayer : public ConvLayer
                     int retID = stride * k;
                     for (int u = 0; u < kernel_height; u++)   for (int v = 0; v < kernel_width; v++)
                         {
-                            for (int i = 0; i < output_height; i++)
+                            for (int i = row_begin; i < row_end; i++)
                             {
                                 for (int j = 0; j < output_width; j++)
                                 {
                                     //calculate each row
-                                    int row = u - (int)padding_top  + i * (int)stride_height;
-                                    int col = v - (int)padding_left + j * (int)stride_width;
+                                    int row = u * (int)dilation_height - (int)padding_top  + i * (int)stride_height;
+                                    int col = v * (int)dilation_width - (int)padding_left + j * (int)stride_width;
                                     //printf("row %d, col %d\n", row, col);
                                     if (row < 0 || row >= input_height || col < 0 || col >= input_width)
                                     {
@@ -287,39 +269,44 @@ class ConvIm2colLayer : public ConvLayer
         int Init()
         {
             int M = (int)output_channels;
-            int N = output_height * output_width;
             int K = (int)input_channels * (int)kernel_height * (int)kernel_width;
-            int eM = M + (8 - M % 8) % 8;
 
-
-#ifdef USE_LEGACY_SGEMM
-	    pack_array_size = 0;
-            MEMPOOL_CHECK_RETURN(private_mempool.Alloc(&packed_kernel, sizeof(float) * eM * K))
-            if (M % 8 == 0)
+            if (sparse)
             {
-                externalPackA8(M, K, packed_kernel, kernel_data, K);
+                block_sparse_encode(&sparse_kernel, kernel_data, M, K);
             }
             else
             {
-                externalPackA(M, K, packed_kernel, kernel_data, K);
+                MEMPOOL_CHECK_RETURN(private_mempool.Alloc(&packed_kernel, sizeof(float) * (M * K)))
+                MEMPOOL_CHECK_RETURN(AllocPackArray())
+                packed_sgemm_init<4>(M, K, kc, packed_kernel, kernel_data, K);
             }
-#else
-	    pack_array_size = (kc + 8) * nc * num_threads;
-            MEMPOOL_CHECK_RETURN(private_mempool.Alloc(&packed_kernel, sizeof(float) * (M * K)))
-            MEMPOOL_CHECK_RETURN(private_mempool.Alloc(&pack_array, sizeof(float) * pack_array_size))
-	    packed_sgemm_init<4>(M, K, kc, packed_kernel, kernel_data, K);
-	    
-            //MEMPOOL_CHECK_RETURN(private_mempool.Alloc(&pack_array, sizeof(float) * (kc + 8) * nc) * this->num_threads);
+
 	    if(bias_term && fuse_relu)
+	    {
 		    packed_sgemm = packed_sgemm_activation<true, true>;
+		    packed_sgemm_strided = packed_sgemm_strided_activation<true, true>;
+		    sparse_sgemm = block_sparse_sgemm<true, true>;
+	    }
 	    else if(bias_term)
+	    {
 		    packed_sgemm = packed_sgemm_activation<true, false>;
+		    packed_sgemm_strided = packed_sgemm_strided_activation<true, false>;
+		    sparse_sgemm = block_sparse_sgemm<true, false>;
+	    }
 	    else if(fuse_relu)
+	    {
 		    packed_sgemm = packed_sgemm_activation<false, true>;
+		    packed_sgemm_strided = packed_sgemm_strided_activation<false, true>;
+		    sparse_sgemm = block_sparse_sgemm<false, true>;
+	    }
 	    else
+	    {
 		    packed_sgemm = packed_sgemm_activation<false, false>;
-#endif
-            MEMPOOL_CHECK_RETURN(common_mempool->Request(sizeof(float) * (input_channels * kernel_height * kernel_width) * (output_width * output_height)))
+		    packed_sgemm_strided = packed_sgemm_strided_activation<false, false>;
+		    sparse_sgemm = block_sparse_sgemm<false, false>;
+	    }
+            MEMPOOL_CHECK_RETURN(common_mempool->Request(ScratchSize()))
             //Setup input and output pointers.
             input = _bottom_blobs[_bottom[0]]->data();
             output = _top_blobs[_top[0]]->data();
@@ -327,6 +314,29 @@ class ConvIm2colLayer : public ConvLayer
         }
 
     private:
+        //Every thread packs its own column block of B, the array grows when the layer gets more threads.
+        bool AllocPackArray()
+        {
+            int size = (kc + 8) * nc * num_threads;
+            if (size <= pack_array_size)
+                return true;
+            if (pack_array_size)
+                private_mempool.Free(&pack_array);
+            pack_array_size = size;
+            return private_mempool.Alloc(&pack_array, sizeof(float) * size);
+        }
+
+        //output (M x N) = weights * b (K x N), b and output with leading dimension N.
+        void Gemm(int N, float* b, float* c)
+        {
+            const int M = output_channels;
+            const int K = input_channels * kernel_width * kernel_height;
+            if (sparse)
+                sparse_sgemm(sparse_kernel, N, b, N, c, N, bias_data, num_threads);
+            else
+                packed_sgemm(M, N, K, packed_kernel, b, N, c, N, nc, kc, bias_data, num_threads, pack_array);
+        }
+
         float* packed_kernel;
         float* img_buffer;
 
@@ -336,7 +346,11 @@ class ConvIm2colLayer : public ConvLayer
         float* input;
         float* output;
 	bool fuse_relu;
+	bool sparse;
+	BlockSparseMatrix sparse_kernel;
 	int  kc, nc;
 	void (*packed_sgemm)(int M, int N, int K, float *packA, float *b, int ldb, float *c, int ldc, int nc, int kc, float* bias, int num_threads, float* pack_array);
+	void (*packed_sgemm_strided)(int M, int N, int K, float *packA, float *b, int ldb, int out_width, int in_width, int stride, float *c, int ldc, int nc, int kc, float* bias, int num_threads, float* pack_array);
+	void (*sparse_sgemm)(const BlockSparseMatrix& a, const int N, const float* b, const int ldb, float* c, const int ldc, const float* bias, const int num_threads);
 };
 };
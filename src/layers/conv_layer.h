@@ -16,8 +16,10 @@
 
 #include "../feather_simple_generated.h"
 #include "../layer.h"
+#include "pooling_layer.h"
 #include "./arm/helper.h"
 #include <assert.h>
+#include <math.h>
 #include <stdio.h>
 
 namespace feather
@@ -26,7 +28,8 @@ class ConvLayer : public Layer
 {
     public:
         ConvLayer(const LayerParameter *layer_param, const RuntimeParameter<float>* rt_param)
-            : Layer(layer_param, rt_param)
+            : fuse_pool(false),
+              Layer(layer_param, rt_param)
         {
             //From proto
             const ConvolutionParameter *conv_param = layer_param->convolution_param();
@@ -40,6 +43,7 @@ class ConvLayer : public Layer
             stride_height = conv_param->stride_h();
             stride_width = conv_param->stride_w();
 
+            ParseDilation(conv_param, &dilation_height, &dilation_width);
             padding_left = conv_param->pad_w();
             padding_top = conv_param->pad_h();
             padding_right = conv_param->pad_w();
@@ -73,8 +77,8 @@ class ConvLayer : public Layer
                 stride_width = 1;
                 stride_height = 1;
             }
-            output_width = (input_width + padding_left + padding_right - kernel_width) / stride_width + 1;
-            output_height = (input_height + padding_top + padding_bottom - kernel_height) / stride_height + 1;
+            output_width = (input_width + padding_left + padding_right - kernel_extent_w()) / stride_width + 1;
+            output_height = (input_height + padding_top + padding_bottom - kernel_extent_h()) / stride_height + 1;
 #if 0
             printf("input channels %d\n", input_channels);
             assert(input_channels == bottom_blob->channels());
@@ -96,11 +100,10 @@ class ConvLayer : public Layer
             input_height    = bottom_blob->height();
             input_width     = bottom_blob->width();
 
-            output_width  = (input_width + padding_left + padding_right - kernel_width) / stride_width + 1;
-            output_height = (input_height + padding_top + padding_bottom - kernel_height) / stride_height + 1;
+            output_width  = (input_width + padding_left + padding_right - kernel_extent_w()) / stride_width + 1;
+            output_height = (input_height + padding_top + padding_bottom - kernel_extent_h()) / stride_height + 1;
 
             _top_blobs[_top[0]]->ReshapeWithRealloc(1, output_channels, output_height, output_width);
-            LOGI("output (c %d h %d w %d)", output_channels, output_height, output_width);
 
             return this->Forward();
         }
@@ -110,7 +113,113 @@ class ConvLayer : public Layer
             return -1;
         }
 
+        //Caffe order, one value for both dimensions or (h, w). Missing or zero means 1.
+        static void ParseDilation(const ConvolutionParameter *conv_param, size_t *dilation_height, size_t *dilation_width)
+        {
+            *dilation_height = 1;
+            *dilation_width = 1;
+            if (VectorLength(conv_param->dilation()) > 0)
+            {
+                *dilation_height = conv_param->dilation()->Get(0);
+                *dilation_width = (VectorLength(conv_param->dilation()) > 1) ? conv_param->dilation()->Get(1) : *dilation_height;
+            }
+            if (*dilation_height == 0) *dilation_height = 1;
+            if (*dilation_width == 0) *dilation_width = 1;
+        }
+
+        //Input span of the dilated kernel.
+        size_t kernel_extent_h() const
+        {
+            return dilation_height * (kernel_height - 1) + 1;
+        }
+        size_t kernel_extent_w() const
+        {
+            return dilation_width * (kernel_width - 1) + 1;
+        }
+
+        //1x1 stride 1 convolution without padding, i.e. a plain GEMM over the input.
+        bool is_pointwise() const
+        {
+            return kernel_width == 1 && kernel_height == 1 && stride_width == 1 && stride_height == 1
+                   && padding_left == 0 && padding_right == 0 && padding_top == 0 && padding_bottom == 0 && group == 1;
+        }
+
+        //1x1 convolution without padding, the GEMM reads every stride-th input pixel without unrolling.
+        bool is_unpadded_1x1() const
+        {
+            return kernel_width == 1 && kernel_height == 1 && stride_width == stride_height
+                   && padding_left == 0 && padding_right == 0 && padding_top == 0 && padding_bottom == 0 && group == 1;
+        }
+
     protected:
+        /*
+         * Absorbs a following non-global pooling layer. The top blob then holds the pooled map and
+         * the full resolution conv output only lives in band sized scratch, see PoolBandBegin/End.
+         */
+        int FusePooling(Layer *next_layer)
+        {
+            if (fuse_pool || group != 1 || next_layer->type().compare("Pooling") != 0)
+                return 0;
+            const PoolingLayer *pool_layer = (const PoolingLayer *) next_layer;
+            if (pool_layer->is_global_pooling())
+                return 0;
+            pool_max = pool_layer->is_max_pooling();
+            pool_kernel_h = pool_layer->window_h();
+            pool_kernel_w = pool_layer->window_w();
+            pool_stride_h = pool_layer->window_stride_h();
+            pool_stride_w = pool_layer->window_stride_w();
+            pool_pad_h = pool_layer->window_pad_h();
+            pool_pad_w = pool_layer->window_pad_w();
+            fuse_pool = true;
+
+            TakeOverTop(next_layer);
+            pooled_height = _top_blobs[_top[0]]->height();
+            pooled_width = _top_blobs[_top[0]]->width();
+            return 1;
+        }
+
+        //Same rounding as PoolingLayer.
+        void UpdatePooledShape()
+        {
+            pooled_height = static_cast<int>(ceil(static_cast<float>(output_height + 2 * pool_pad_h - pool_kernel_h) / pool_stride_h)) + 1;
+            pooled_width = static_cast<int>(ceil(static_cast<float>(output_width + 2 * pool_pad_w - pool_kernel_w) / pool_stride_w)) + 1;
+        }
+
+        //Picks how many pooled rows are produced per band, given a target number of conv rows per band.
+        void SetupPoolBands(size_t conv_rows)
+        {
+            if (conv_rows < pool_kernel_h)
+                conv_rows = pool_kernel_h;
+            pool_band_rows = (conv_rows - pool_kernel_h) / pool_stride_h + 1;
+            if (pool_band_rows > pooled_height)
+                pool_band_rows = pooled_height;
+            conv_band_rows = (pool_band_rows - 1) * pool_stride_h + pool_kernel_h;
+            if (conv_band_rows > output_height)
+                conv_band_rows = output_height;
+        }
+
+        //Conv output rows [PoolBandBegin(begin), PoolBandEnd(end)) feed pooled rows [begin, end).
+        size_t PoolBandBegin(size_t pooled_row_begin)
+        {
+            int row = (int)(pooled_row_begin * pool_stride_h) - (int)pool_pad_h;
+            row = (row < 0) ? 0 : row;
+            return (row > (int)output_height) ? output_height : row;
+        }
+
+        size_t PoolBandEnd(size_t pooled_row_end)
+        {
+            int row = (int)((pooled_row_end - 1) * pool_stride_h + pool_kernel_h) - (int)pool_pad_h;
+            row = (row < 0) ? 0 : row;
+            return (row > (int)output_height) ? output_height : row;
+        }
+
+        void PoolBand(float *output, const float *band, size_t row_begin, size_t row_end, size_t pooled_row_begin, size_t pooled_row_end)
+        {
+            pooling_rows(output, band, pool_max, output_channels, output_height, output_width, row_begin, row_end - row_begin,
+                         pooled_height, pooled_width, pooled_row_begin, pooled_row_end,
+                         pool_kernel_h, pool_kernel_w, pool_stride_h, pool_stride_w, pool_pad_h, pool_pad_w, num_threads);
+        }
+
         size_t input_channels;
         size_t input_width;
         size_t input_height;
@@ -125,6 +234,9 @@ class ConvLayer : public Layer
         size_t stride_width;
         size_t stride_height;
 
+        size_t dilation_width;
+        size_t dilation_height;
+
         size_t padding_left;
         size_t padding_right;
         size_t padding_top;
@@ -136,5 +248,18 @@ class ConvLayer : public Layer
 
         float *kernel_data;
         float *bias_data;
+
+        bool fuse_pool;
+        bool pool_max;
+        size_t pool_kernel_h;
+        size_t pool_kernel_w;
+        size_t pool_stride_h;
+        size_t pool_stride_w;
+        size_t pool_pad_h;
+        size_t pool_pad_w;
+        size_t pooled_height;
+        size_t pooled_width;
+        size_t pool_band_rows;
+        size_t conv_band_rows;
 };
 };
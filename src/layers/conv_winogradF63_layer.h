@@ -44,7 +44,7 @@ class ConvWinogradF63Layer : public ConvLayer
             const size_t inputw = input_width + padding_left + padding_right;
             const size_t inputh = input_height + padding_top + padding_bottom;
             int nRowBlocks = (inputw + 3) / 6;
-            int nColBlocks = (inputh + 3) / 6;
+            int nColBlocks = fuse_pool ? (conv_band_rows + 5) / 6 : (inputh + 3) / 6;
             int nBlocks = nRowBlocks * nColBlocks;
             //Get addresses
             float *VT = common_mem;
@@ -52,26 +52,37 @@ class ConvWinogradF63Layer : public ConvLayer
             float *padded_input = WT + 64 * nBlocks * output_channels; //Offset by sizeof WT
             float *pack_array = padded_input + inputw * inputh * input_channels; //Offset by sizeof WT
             pad_input(padded_input, input, input_channels, input_width, input_height, padding_left, padding_top, padding_right, padding_bottom);
+            if (fuse_pool)
+            {
+                float *band_output = pack_array + getPackArraySize_F6x6_3x3(input_channels, num_threads);
+                for (size_t pr = 0; pr < pooled_height; pr += pool_band_rows)
+                {
+                    size_t pr_end = (pr + pool_band_rows < pooled_height) ? pr + pool_band_rows : pooled_height;
+                    size_t row_begin = PoolBandBegin(pr);
+                    size_t row_end = PoolBandEnd(pr_end);
+                    if (row_end > row_begin)
+                        winogradNonFusedTransformRows_F6x6_3x3(band_output, output_channels, WT, VT, UT, padded_input, input_channels, inputh, inputw, row_begin, row_end, winograd_out_type, bias_data, pack_array, num_threads);
+                    PoolBand(output, band_output, row_begin, row_end, pr, pr_end);
+                }
+                return 0;
+            }
             winogradNonFusedTransform_F6x6_3x3(output, output_channels, WT, VT, UT, padded_input, input_channels, inputh, inputw, winograd_out_type, bias_data, pack_array, num_threads);
             return 0;
         }
 
-        virtual int ForwardReshape()
+        //Scratch layout: VT, WT, padded input, pack array and, when pooling is fused, the conv output band.
+        size_t ScratchSize()
         {
-            // LOGI("Winograd F63 output before reshape (c %d h %d w %d)", output_channels, output_height, output_width);
-            const Blob<float> *bottom_blob = _bottom_blobs[_bottom[0]];
-            
-            size_t input_height_old = input_height;
-            size_t input_width_old = input_width;
-            input_height    = bottom_blob->height();
-            input_width     = bottom_blob->width();
-
-            output_width  = (input_width + padding_left + padding_right - kernel_width) / stride_width + 1;
-            output_height = (input_height + padding_top + padding_bottom - kernel_height) / stride_height + 1;
-            if((input_height > input_height_old) || (input_width > input_width_old))
-            {//Global memory allocations
             size_t inputw = input_width + padding_left + padding_right;
             size_t inputh = input_height + padding_top + padding_bottom;
+            size_t band_size = 0;
+            if (fuse_pool)
+            {
+                //Four rows of tiles per band keeps the transforms busy.
+                SetupPoolBands(24);
+                inputh = conv_band_rows + 2;
+                band_size = output_channels * conv_band_rows * output_width;
+            }
             int nRowBlocks = (inputw + 3) / 6;
             int nColBlocks = (inputh + 3) / 6;
             int nBlocks = nRowBlocks * nColBlocks;
@@ -80,12 +91,30 @@ class ConvWinogradF63Layer : public ConvLayer
             winograd_mem_size += 64 * nBlocks * input_channels;  //VT
             winograd_mem_size += 64 * nBlocks * output_channels; //WT
             winograd_mem_size += packArraySize; //WT
-            winograd_mem_size += inputw * inputh * input_channels;                           //Padded Input
+            winograd_mem_size += inputw * (input_height + padding_top + padding_bottom) * input_channels; //Padded Input
+            winograd_mem_size += band_size;
 	        winograd_mem_size += 64;
+            return winograd_mem_size * sizeof(float);
+        }
 
-            MEMPOOL_CHECK_RETURN(common_mempool->Alloc(winograd_mem_size * sizeof(float)));
-            }
-            _top_blobs[_top[0]]->ReshapeWithRealloc(1, output_channels, output_height, output_width);
+        virtual int ForwardReshape()
+        {
+            // LOGI("Winograd F63 output before reshape (c %d h %d w %d)", output_channels, output_height, output_width);
+            const Blob<float> *bottom_blob = _bottom_blobs[_bottom[0]];
+            
+            input_height    = bottom_blob->height();
+            input_width     = bottom_blob->width();
+
+            output_width  = (input_width + padding_left + padding_right - kernel_width) / stride_width + 1;
+            output_height = (input_height + padding_top + padding_bottom - kernel_height) / stride_height + 1;
+            if (fuse_pool)
+                UpdatePooledShape();
+            //The pack array grows with the thread count too, Alloc only ever grows the pool.
+            MEMPOOL_CHECK_RETURN(common_mempool->Alloc(ScratchSize()));
+            if (fuse_pool)
+                _top_blobs[_top[0]]->ReshapeWithRealloc(1, output_channels, pooled_height, pooled_width);
+            else
+                _top_blobs[_top[0]]->ReshapeWithRealloc(1, output_channels, output_height, output_width);
 
             //We have to update the input and output ptrs to avoid pointer reallocation.
             output = _top_blobs[_top[0]]->data();
@@ -98,32 +127,21 @@ class ConvWinogradF63Layer : public ConvLayer
         {
             if (next_layer->type().compare("ReLU") == 0)
             {
+                //ReLU commutes with max pooling only.
+                if (fuse_pool && !pool_max)
+                    return 0;
                 fuse_relu = true;
                 return 1;
             }
             else
             {
-                return 0;
+                return FusePooling(next_layer);
             }
         }
 
         int Init()
         {
-            size_t inputw = input_width + padding_left + padding_right;
-            size_t inputh = input_height + padding_top + padding_bottom;
-            int nRowBlocks = (inputw + 3) / 6;
-            int nColBlocks = (inputh + 3) / 6;
-            int nBlocks = nRowBlocks * nColBlocks;
-
-            size_t packArraySize = getPackArraySize_F6x6_3x3(input_channels, num_threads);
-            size_t winograd_mem_size = 0;
-            winograd_mem_size += 64 * nBlocks * input_channels;  //VT
-            winograd_mem_size += 64 * nBlocks * output_channels; //WT
-            winograd_mem_size += packArraySize; //WT
-            winograd_mem_size += inputw * inputh * input_channels;                           //Padded Input
-	        winograd_mem_size += 64;
-
-            MEMPOOL_CHECK_RETURN(common_mempool->Request(winograd_mem_size * sizeof(float)));
+            MEMPOOL_CHECK_RETURN(common_mempool->Request(ScratchSize()));
             MEMPOOL_CHECK_RETURN(private_mempool.Alloc(&UT, 64 * input_channels * output_channels * sizeof(float)));
             transformKernel_F6x6_3x3(UT, kernel_data, input_channels, output_channels);
             if (bias_term && fuse_relu)
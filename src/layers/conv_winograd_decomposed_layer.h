@@ -0,0 +1,193 @@
+//Tencent is pleased to support the open source community by making FeatherCNN available.
+
+//Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+
+//Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+//in compliance with the License. You may obtain a copy of the License at
+//
+//https://opensource.org/licenses/BSD-3-Clause
+//
+//Unless required by applicable law or agreed to in writing, software distributed
+//under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//CONDITIONS OF ANY KIND, either express or implied. See the License for the
+//specific language governing permissions and limitations under the License.
+
+#pragma once
+
+#include "../feather_simple_generated.h"
+#include "conv_winograd_tile_layer.h"
+#include "blob.h"
+
+#include "arm/generic_kernels.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace feather
+{
+/*
+ * Runs 5x5 and stride 2 convolutions as one 3x3 stride 1 Winograd convolution over four times
+ * the input channels. Each group of channels ("piece") samples the padded input at
+ * (step * y + offset_y, step * x + offset_x) and gets the matching taps of the kernel:
+ *
+ * 5x5 stride 1: the kernel is zero padded to 6x6 and split in four 3x3 quarters, offsets {0, 3}.
+ * stride 2:     polyphase split, offsets {0, 1} with step 2. 3x3 kernels give 2x2, 2x1, 1x2 and
+ *               1x1 phases, 5x5 kernels give 3x3, 3x2, 2x3 and 2x2 phases, all zero padded to 3x3.
+ *
+ * The GEMM over the input channels sums the pieces, so only the kernels and the input gathering
+ * differ from a plain 3x3 layer.
+ */
+class ConvWinogradDecomposedLayer : public ConvWinogradTileLayer
+{
+    public:
+        ConvWinogradDecomposedLayer(const LayerParameter *layer_param, const RuntimeParameter<float>* rt_param, size_t tile)
+            : ConvWinogradTileLayer(layer_param, rt_param, tile)
+        {
+            step = stride_height;
+            for (int p = 0; p < 4; ++p)
+            {
+                //Stride 2 splits into phases, 5x5 stride 1 into quarters of the 6x6 kernel.
+                size_t offset = (step == 2) ? 1 : 3;
+                piece_y[p] = (p / 2) * offset;
+                piece_x[p] = (p % 2) * offset;
+            }
+        }
+
+        //Kernels and strides this layer decomposes into 3x3 stride 1.
+        static bool Supports(size_t kernel_height, size_t kernel_width, size_t stride_height, size_t stride_width)
+        {
+            if (kernel_height != kernel_width || stride_height != stride_width)
+                return false;
+            return (kernel_height == 5 && stride_height <= 2) || (kernel_height == 3 && stride_height == 2);
+        }
+
+        int Forward()
+        {
+            float* common_mem = NULL;
+            MEMPOOL_CHECK_RETURN(common_mempool->GetPtr(&common_mem));
+            const size_t inputw = output_width + 2;
+            const size_t inputh = output_height + 2;
+            const size_t channels = 4 * input_channels;
+            const size_t nBlocks = NumBlocks(inputh, inputw);
+            //Get addresses
+            float *VT = common_mem;
+            float *WT = VT + TileElems() * nBlocks * channels;        //Offset by sizeof VT
+            float *pieces = WT + TileElems() * nBlocks * output_channels; //Offset by sizeof WT
+            float *pack_array = pieces + inputw * inputh * channels;     //Offset by sizeof pieces
+            GatherPieces(pieces, inputh, inputw);
+            Transform(output, WT, VT, pieces, channels, inputh, inputw, pack_array);
+            return 0;
+        }
+
+        //Scratch layout: VT, WT, the gathered pieces and the pack array.
+        size_t ScratchSize()
+        {
+            const size_t inputw = output_width + 2;
+            const size_t inputh = output_height + 2;
+            const size_t channels = 4 * input_channels;
+            const size_t nBlocks = NumBlocks(inputh, inputw);
+            size_t winograd_mem_size = 0;
+            winograd_mem_size += TileElems() * nBlocks * channels;        //VT
+            winograd_mem_size += TileElems() * nBlocks * output_channels; //WT
+            winograd_mem_size += inputw * inputh * channels;              //Pieces
+            winograd_mem_size += PackArraySize(channels);
+            return winograd_mem_size * sizeof(float);
+        }
+
+        virtual int ForwardReshape()
+        {
+            const Blob<float> *bottom_blob = _bottom_blobs[_bottom[0]];
+            input_height    = bottom_blob->height();
+            input_width     = bottom_blob->width();
+
+            output_width  = (input_width + padding_left + padding_right - kernel_width) / stride_width + 1;
+            output_height = (input_height + padding_top + padding_bottom - kernel_height) / stride_height + 1;
+
+            _top_blobs[_top[0]]->ReshapeWithRealloc(1, output_channels, output_height, output_width);
+            MEMPOOL_CHECK_RETURN(common_mempool->Alloc(ScratchSize()));
+            output = _top_blobs[_top[0]]->data();
+            input = _bottom_blobs[_bottom[0]]->data();
+            return this->Forward();
+        }
+
+        int Init()
+        {
+            const size_t channels = 4 * input_channels;
+            float* pieces_kernel = NULL;
+            MEMPOOL_CHECK_RETURN(common_mempool->Request(ScratchSize()));
+            MEMPOOL_CHECK_RETURN(private_mempool.Alloc(&pieces_kernel, 9 * channels * output_channels * sizeof(float)));
+            SplitKernel(pieces_kernel);
+            MEMPOOL_CHECK_RETURN(InitTransform(pieces_kernel, channels));
+            MEMPOOL_CHECK_RETURN(private_mempool.Free(&pieces_kernel));
+            //Setup input and output pointers.
+            input = _bottom_blobs[_bottom[0]]->data();
+            output = _top_blobs[_top[0]]->data();
+            return 0;
+        }
+
+    private:
+        //3x3 kernels over [piece][input channel], taps past the original kernel are zero.
+        void SplitKernel(float *pieces_kernel)
+        {
+            const size_t channels = 4 * input_channels;
+            memset(pieces_kernel, 0, sizeof(float) * 9 * channels * output_channels);
+            for (size_t oc = 0; oc < output_channels; ++oc)
+            {
+                for (int p = 0; p < 4; ++p)
+                {
+                    for (size_t ic = 0; ic < input_channels; ++ic)
+                    {
+                        const float *kp = kernel_data + (oc * input_channels + ic) * kernel_height * kernel_width;
+                        float *pkp = pieces_kernel + (oc * channels + p * input_channels + ic) * 9;
+                        for (size_t u = 0; u < 3; ++u)
+                        {
+                            for (size_t v = 0; v < 3; ++v)
+                            {
+                                size_t ky = step * u + piece_y[p];
+                                size_t kx = step * v + piece_x[p];
+                                if (ky < kernel_height && kx < kernel_width)
+                                    pkp[u * 3 + v] = kp[ky * kernel_width + kx];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        //Samples the zero padded input of every piece into inputh x inputw frames.
+        void GatherPieces(float *pieces, size_t inputh, size_t inputw)
+        {
+            #pragma omp parallel for num_threads(num_threads) collapse(2)
+            for (int p = 0; p < 4; ++p)
+            {
+                for (int ic = 0; ic < input_channels; ++ic)
+                {
+                    const float *inp = input + ic * input_height * input_width;
+                    float *outp = pieces + (p * input_channels + ic) * inputh * inputw;
+                    for (int y = 0; y < inputh; ++y)
+                    {
+                        int row = (int)(step * y + piece_y[p]) - (int)padding_top;
+                        if (row < 0 || row >= input_height)
+                        {
+                            memset(outp + y * inputw, 0, sizeof(float) * inputw);
+                            continue;
+                        }
+                        for (int x = 0; x < inputw; ++x)
+                        {
+                            int col = (int)(step * x + piece_x[p]) - (int)padding_left;
+                            outp[y * inputw + x] = (col < 0 || col >= input_width) ? 0.f : inp[row * input_width + col];
+                        }
+                    }
+                }
+            }
+        }
+
+        float* input;
+        float* output;
+
+        size_t step;
+        size_t piece_y[4];
+        size_t piece_x[4];
+};
+};
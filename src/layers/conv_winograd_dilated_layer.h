@@ -0,0 +1,164 @@
+//Tencent is pleased to support the open source community by making FeatherCNN available.
+
+//Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+
+//Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+//in compliance with the License. You may obtain a copy of the License at
+//
+//https://opensource.org/licenses/BSD-3-Clause
+//
+//Unless required by applicable law or agreed to in writing, software distributed
+//under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//CONDITIONS OF ANY KIND, either express or implied. See the License for the
+//specific language governing permissions and limitations under the License.
+
+#pragma once
+
+#include "../feather_simple_generated.h"
+#include "conv_winograd_tile_layer.h"
+#include "blob.h"
+
+#include "arm/generic_kernels.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace feather
+{
+/*
+ * Dilated 3x3 stride 1 convolution through space to batch: output pixels (a + dh * i, b + dw * j)
+ * only read the padded input at (a + dh * y, b + dw * x), so every phase (a, b) is a dense 3x3
+ * convolution on a subsampled frame. Phases run one after the other on the Winograd kernels and
+ * are scattered back into the top blob.
+ */
+class ConvWinogradDilatedLayer : public ConvWinogradTileLayer
+{
+    public:
+        ConvWinogradDilatedLayer(const LayerParameter *layer_param, const RuntimeParameter<float>* rt_param, size_t tile)
+            : ConvWinogradTileLayer(layer_param, rt_param, tile)
+        {
+        }
+
+        int Forward()
+        {
+            float* common_mem = NULL;
+            MEMPOOL_CHECK_RETURN(common_mempool->GetPtr(&common_mem));
+            const size_t max_h = PhaseSize(output_height, dilation_height, 0);
+            const size_t max_w = PhaseSize(output_width, dilation_width, 0);
+            const size_t nBlocks = NumBlocks(max_h + 2, max_w + 2);
+            //Get addresses
+            float *VT = common_mem;
+            float *WT = VT + TileElems() * nBlocks * input_channels;                  //Offset by sizeof VT
+            float *frame = WT + TileElems() * nBlocks * output_channels;              //Offset by sizeof WT
+            float *phase_output = frame + (max_h + 2) * (max_w + 2) * input_channels; //Offset by sizeof frame
+            float *pack_array = phase_output + max_h * max_w * output_channels;       //Offset by sizeof phase output
+            for (size_t a = 0; a < dilation_height; ++a)
+            {
+                for (size_t b = 0; b < dilation_width; ++b)
+                {
+                    const size_t phase_h = PhaseSize(output_height, dilation_height, a);
+                    const size_t phase_w = PhaseSize(output_width, dilation_width, b);
+                    if (phase_h == 0 || phase_w == 0)
+                        continue;
+                    GatherPhase(frame, a, b, phase_h + 2, phase_w + 2);
+                    Transform(phase_output, WT, VT, frame, input_channels, phase_h + 2, phase_w + 2, pack_array);
+                    ScatterPhase(phase_output, a, b, phase_h, phase_w);
+                }
+            }
+            return 0;
+        }
+
+        //Scratch layout: VT, WT, the phase frame, the phase output and the pack array, sized for phase (0, 0).
+        size_t ScratchSize()
+        {
+            const size_t max_h = PhaseSize(output_height, dilation_height, 0);
+            const size_t max_w = PhaseSize(output_width, dilation_width, 0);
+            const size_t nBlocks = NumBlocks(max_h + 2, max_w + 2);
+            size_t winograd_mem_size = 0;
+            winograd_mem_size += TileElems() * nBlocks * input_channels;  //VT
+            winograd_mem_size += TileElems() * nBlocks * output_channels; //WT
+            winograd_mem_size += (max_h + 2) * (max_w + 2) * input_channels; //Phase frame
+            winograd_mem_size += max_h * max_w * output_channels;            //Phase output
+            winograd_mem_size += PackArraySize(input_channels);
+            return winograd_mem_size * sizeof(float);
+        }
+
+        virtual int ForwardReshape()
+        {
+            const Blob<float> *bottom_blob = _bottom_blobs[_bottom[0]];
+            input_height    = bottom_blob->height();
+            input_width     = bottom_blob->width();
+
+            output_width  = (input_width + padding_left + padding_right - kernel_extent_w()) / stride_width + 1;
+            output_height = (input_height + padding_top + padding_bottom - kernel_extent_h()) / stride_height + 1;
+
+            _top_blobs[_top[0]]->ReshapeWithRealloc(1, output_channels, output_height, output_width);
+            MEMPOOL_CHECK_RETURN(common_mempool->Alloc(ScratchSize()));
+            output = _top_blobs[_top[0]]->data();
+            input = _bottom_blobs[_bottom[0]]->data();
+            return this->Forward();
+        }
+
+        int Init()
+        {
+            MEMPOOL_CHECK_RETURN(common_mempool->Request(ScratchSize()));
+            MEMPOOL_CHECK_RETURN(InitTransform(kernel_data, input_channels));
+            //Setup input and output pointers.
+            input = _bottom_blobs[_bottom[0]]->data();
+            output = _top_blobs[_top[0]]->data();
+            return 0;
+        }
+
+    private:
+        //Number of output rows (or columns) i * dilation + phase below size.
+        static size_t PhaseSize(size_t size, size_t dilation, size_t phase)
+        {
+            return (phase < size) ? (size - phase + dilation - 1) / dilation : 0;
+        }
+
+        //Frame of phase (a, b) with the zero padding applied: frame[y][x] = padded[a + dh * y][b + dw * x].
+        void GatherPhase(float *frame, size_t a, size_t b, size_t frameh, size_t framew)
+        {
+            #pragma omp parallel for num_threads(num_threads)
+            for (int ic = 0; ic < input_channels; ++ic)
+            {
+                const float *inp = input + ic * input_height * input_width;
+                float *outp = frame + ic * frameh * framew;
+                for (int y = 0; y < frameh; ++y)
+                {
+                    int row = (int)(a + dilation_height * y) - (int)padding_top;
+                    if (row < 0 || row >= input_height)
+                    {
+                        memset(outp + y * framew, 0, sizeof(float) * framew);
+                        continue;
+                    }
+                    for (int x = 0; x < framew; ++x)
+                    {
+                        int col = (int)(b + dilation_width * x) - (int)padding_left;
+                        outp[y * framew + x] = (col < 0 || col >= input_width) ? 0.f : inp[row * input_width + col];
+                    }
+                }
+            }
+        }
+
+        void ScatterPhase(const float *phase_output, size_t a, size_t b, size_t phase_h, size_t phase_w)
+        {
+            #pragma omp parallel for num_threads(num_threads)
+            for (int oc = 0; oc < output_channels; ++oc)
+            {
+                const float *inp = phase_output + oc * phase_h * phase_w;
+                float *outp = output + oc * output_height * output_width + a * output_width + b;
+                for (int i = 0; i < phase_h; ++i)
+                {
+                    for (int j = 0; j < phase_w; ++j)
+                        outp[j * dilation_width] = inp[i * phase_w + j];
+                    outp += dilation_height * output_width;
+                }
+            }
+        }
+
+        float* input;
+        float* output;
+};
+};
@@ -30,7 +30,7 @@ class ConvWinogradLayer : public ConvLayer
 {
     public:
         ConvWinogradLayer(const LayerParameter *layer_param, const RuntimeParameter<float>* rt_param)
-            : ConvLayer(layer_param, rt_param)
+            : fuse_relu(false), ConvLayer(layer_param, rt_param)
         {
             _fusible = true;
         }
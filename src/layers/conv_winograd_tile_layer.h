@@ -0,0 +1,106 @@
+//Tencent is pleased to support the open source community by making FeatherCNN available.
+
+//Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+
+//Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+//in compliance with the License. You may obtain a copy of the License at
+//
+//https://opensource.org/licenses/BSD-3-Clause
+//
+//Unless required by applicable law or agreed to in writing, software distributed
+//under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//CONDITIONS OF ANY KIND, either express or implied. See the License for the
+//specific language governing permissions and limitations under the License.
+
+#pragma once
+
+#include "../feather_simple_generated.h"
+#include "conv_layer.h"
+
+#include "arm/winograd_kernels.h"
+
+namespace feather
+{
+/*
+ * Base of layers that rewrite a convolution into 3x3 stride 1 convolutions over frames of their
+ * own and run them on the F(6x6, 3x3) or F(4x4, 3x3) kernels, picked by tile (6 or 4). Holds
+ * the tile dependent sizes, the transformed kernel and the fused ReLU.
+ */
+class ConvWinogradTileLayer : public ConvLayer
+{
+    public:
+        ConvWinogradTileLayer(const LayerParameter *layer_param, const RuntimeParameter<float>* rt_param, size_t tile)
+            : tile(tile), fuse_relu(false), ConvLayer(layer_param, rt_param)
+        {
+            _fusible = true;
+        }
+
+        int Fuse(Layer *next_layer)
+        {
+            if (next_layer->type().compare("ReLU") == 0)
+            {
+                fuse_relu = true;
+                return 1;
+            }
+            else
+                return 0;
+        }
+
+    protected:
+        //Floats per transformed tile.
+        size_t TileElems() const
+        {
+            return (tile + 2) * (tile + 2);
+        }
+
+        //Tiles covering an inputh x inputw frame.
+        size_t NumBlocks(size_t inputh, size_t inputw) const
+        {
+            if (tile == 6)
+                return ((inputw + 3) / 6) * ((inputh + 3) / 6);
+            return ((inputw + 1) / 4) * ((inputh + 1) / 4);
+        }
+
+        //Floats of the pack array for the given input channels, with the slack the F63 layer keeps too.
+        size_t PackArraySize(size_t channels) const
+        {
+            if (tile == 6)
+                return getPackArraySize_F6x6_3x3(channels, num_threads) + 64;
+            return getPackArraySize_F4x4_3x3(channels, num_threads);
+        }
+
+        //Transforms 3x3 kernels over the given input channels into UT and picks the output type.
+        bool InitTransform(float *kernel, size_t channels)
+        {
+            MEMPOOL_CHECK_RETURN(private_mempool.Alloc(&UT, TileElems() * channels * output_channels * sizeof(float)));
+            if (tile == 6)
+                transformKernel_F6x6_3x3(UT, kernel, channels, output_channels);
+            else
+                transformKernel_F4x4_3x3(UT, kernel, channels, output_channels);
+
+            if (bias_term && fuse_relu)
+                winograd_out_type = BiasReLU;
+            else if (bias_term)
+                winograd_out_type = Bias;
+            else if (fuse_relu)
+                winograd_out_type = ReLU;
+            else
+                winograd_out_type = None;
+            return true;
+        }
+
+        //3x3 convolution of an inputh x inputw frame, the output is (inputh - 2) x (inputw - 2).
+        void Transform(float *output, float *WT, float *VT, float *frame, size_t channels, size_t inputh, size_t inputw, float *pack_array)
+        {
+            if (tile == 6)
+                winogradNonFusedTransform_F6x6_3x3(output, output_channels, WT, VT, UT, frame, channels, inputh, inputw, winograd_out_type, bias_data, pack_array, num_threads);
+            else
+                winogradNonFusedTransform_F4x4_3x3(output, output_channels, WT, VT, UT, frame, channels, inputh, inputw, winograd_out_type, bias_data, pack_array, num_threads);
+        }
+
+        float* UT;
+        size_t tile;
+        bool fuse_relu;
+        WinogradOutType winograd_out_type;
+};
+};
@@ -0,0 +1,197 @@
+//Tencent is pleased to support the open source community by making FeatherCNN available.
+
+//Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+
+//Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+//in compliance with the License. You may obtain a copy of the License at
+//
+//https://opensource.org/licenses/BSD-3-Clause
+//
+//Unless required by applicable law or agreed to in writing, software distributed
+//under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//CONDITIONS OF ANY KIND, either express or implied. See the License for the
+//specific language governing permissions and limitations under the License.
+
+#pragma once
+
+#include "../feather_simple_generated.h"
+#include "conv_layer.h"
+#include "blob.h"
+
+#include "arm/sgemm.h"
+#include "arm/deconv.h"
+
+#include <assert.h>
+#include <stdio.h>
+
+namespace feather
+{
+/*
+ * Transposed convolution with Caffe weights (input channels, output channels / group, kh, kw).
+ * Per group the GEMM col = W^T * input gives every tap of every input pixel, col2im then
+ * accumulates the taps into the output and applies bias and ReLU. 1x1 stride 1 layers without
+ * padding write the GEMM output directly.
+ */
+class DeconvLayer : public ConvLayer
+{
+    public:
+        DeconvLayer(const LayerParameter *layer_param, const RuntimeParameter<float>* rt_param)
+            : fuse_relu(false), kc(320), nc(160), pack_array_size(0), ConvLayer(layer_param, rt_param)
+        {
+            _fusible = true;
+            input_channels = this->_weight_blobs[0]->num();
+            output_channels = this->_weight_blobs[0]->channels() * group;
+        }
+
+        int Forward()
+        {
+            const int N = input_height * input_width;
+            const int M = output_channels / group * kernel_height * kernel_width;
+            const int K = input_channels / group;
+            MEMPOOL_CHECK_RETURN(AllocPackArray());
+            if (is_pointwise())
+            {
+                packed_sgemm(M, N, K, packed_kernel, input, N, output, N, nc, kc, bias_data, num_threads, pack_array);
+                return 0;
+            }
+            float* col = NULL;
+            MEMPOOL_CHECK_RETURN(common_mempool->GetPtr(&col));
+            for (int g = 0; g < group; ++g)
+                packed_sgemm_activation<false, false>(M, N, K, packed_kernel + g * M * K, input + g * K * N, N, col + g * M * N, N, nc, kc, NULL, num_threads, pack_array);
+            col2im_fn(output, col, output_channels, input_height, input_width, output_height, output_width,
+                      kernel_height, kernel_width, stride_height, stride_width, padding_top, padding_left,
+                      dilation_height, dilation_width, bias_data, num_threads);
+            return 0;
+        }
+
+        //Scratch layout: the GEMM output of all groups.
+        size_t ScratchSize()
+        {
+            if (is_pointwise())
+                return 0;
+            return sizeof(float) * output_channels * kernel_height * kernel_width * input_height * input_width;
+        }
+
+        int GenerateTopBlobs()
+        {
+            const Blob<float> *bottom_blob = _bottom_blobs[_bottom[0]];
+            if (bottom_blob->channels() != input_channels)
+            {
+                LOGE("Deconvolution %s expects %zu input channels, got %zu\n", this->name().c_str(), input_channels, bottom_blob->channels());
+                return -1;
+            }
+            input_width = bottom_blob->width();
+            input_height = bottom_blob->height();
+            UpdateOutputShape();
+            _top_blobs[_top[0]] = new Blob<float>(1, output_channels, output_height, output_width);
+            _top_blobs[_top[0]]->Alloc();
+            return 0;
+        }
+
+        virtual int ForwardReshape()
+        {
+            const Blob<float> *bottom_blob = _bottom_blobs[_bottom[0]];
+            input_height    = bottom_blob->height();
+            input_width     = bottom_blob->width();
+            UpdateOutputShape();
+
+            _top_blobs[_top[0]]->ReshapeWithRealloc(1, output_channels, output_height, output_width);
+            MEMPOOL_CHECK_RETURN(common_mempool->Alloc(ScratchSize()));
+            input = _bottom_blobs[_bottom[0]]->data();
+            output = _top_blobs[_top[0]]->data();
+            return this->Forward();
+        }
+
+        int Fuse(Layer *next_layer)
+        {
+            if (next_layer->type().compare("ReLU") == 0)
+            {
+                fuse_relu = true;
+                return 1;
+            }
+            else
+                return 0;
+        }
+
+        int Init()
+        {
+            const int M = output_channels / group * kernel_height * kernel_width;
+            const int K = input_channels / group;
+            float* kernel_t = NULL;
+            MEMPOOL_CHECK_RETURN(private_mempool.Alloc(&packed_kernel, sizeof(float) * M * K * group));
+            MEMPOOL_CHECK_RETURN(AllocPackArray());
+            MEMPOOL_CHECK_RETURN(private_mempool.Alloc(&kernel_t, sizeof(float) * M * K));
+            //Weights of a group are K x M, the GEMM wants them M x K.
+            for (int g = 0; g < group; ++g)
+            {
+                const float* kp = kernel_data + g * K * M;
+                for (int m = 0; m < M; ++m)
+                    for (int k = 0; k < K; ++k)
+                        kernel_t[m * K + k] = kp[k * M + m];
+                packed_sgemm_init<4>(M, K, kc, packed_kernel + g * M * K, kernel_t, K);
+            }
+            MEMPOOL_CHECK_RETURN(private_mempool.Free(&kernel_t));
+
+            if (bias_term && fuse_relu)
+            {
+                packed_sgemm = packed_sgemm_activation<true, true>;
+                col2im_fn = col2im<true, true>;
+            }
+            else if (bias_term)
+            {
+                packed_sgemm = packed_sgemm_activation<true, false>;
+                col2im_fn = col2im<true, false>;
+            }
+            else if (fuse_relu)
+            {
+                packed_sgemm = packed_sgemm_activation<false, true>;
+                col2im_fn = col2im<false, true>;
+            }
+            else
+            {
+                packed_sgemm = packed_sgemm_activation<false, false>;
+                col2im_fn = col2im<false, false>;
+            }
+            MEMPOOL_CHECK_RETURN(common_mempool->Request(ScratchSize()));
+            //Setup input and output pointers.
+            input = _bottom_blobs[_bottom[0]]->data();
+            output = _top_blobs[_top[0]]->data();
+            return 0;
+        }
+
+    private:
+        //A GEMM panel per thread, grown when the layer gets more threads.
+        bool AllocPackArray()
+        {
+            size_t size = (kc + 8) * nc * num_threads;
+            if (size <= pack_array_size)
+                return true;
+            if (pack_array_size)
+                private_mempool.Free(&pack_array);
+            pack_array_size = size;
+            return private_mempool.Alloc(&pack_array, sizeof(float) * size);
+        }
+
+        //Caffe's deconvolution shape, the inverse of the convolution one.
+        void UpdateOutputShape()
+        {
+            output_height = stride_height * (input_height - 1) + kernel_extent_h() - padding_top - padding_bottom;
+            output_width = stride_width * (input_width - 1) + kernel_extent_w() - padding_left - padding_right;
+        }
+
+        float* packed_kernel;
+        float* pack_array;
+        size_t pack_array_size;
+
+        float* input;
+        float* output;
+
+        bool fuse_relu;
+        int kc, nc;
+        void (*packed_sgemm)(int M, int N, int K, float *packA, float *b, int ldb, float *c, int ldc, int nc, int kc, float* bias, int num_threads, float* pack_array);
+        void (*col2im_fn)(float* output, const float* col, const int channels, const int input_h, const int input_w,
+                          const int output_h, const int output_w, const int kernel_h, const int kernel_w,
+                          const int stride_h, const int stride_w, const int pad_h, const int pad_w,
+                          const int dilation_h, const int dilation_w, const float* bias, const int num_threads);
+};
+};
@@ -48,6 +48,12 @@ class EltwiseLayer : public Layer
             return 0;
         }
 
+        //Padded channels are zero on both sides, so the sum runs over the raw buffers.
+        bool SupportsPackedLayout()
+        {
+            return true;
+        }
+
         int Fuse(Layer *next_layer)
         {
             if (next_layer->type().compare("ReLU") == 0)
@@ -77,6 +83,14 @@ class EltwiseLayer : public Layer
             return 0;
         }
 
+        int ForwardReshape()
+        {
+            _top_blobs[_top[0]]->ReshapeWithRealloc(_bottom_blobs[_bottom[0]]);
+            //Buffers may have moved.
+            Init();
+            return Forward();
+        }
+
         int Init()
         {
             input_alpha = _bottom_blobs[_bottom[0]]->data();
@@ -17,17 +17,24 @@
 #include "../feather_simple_generated.h"
 #include "../layer.h"
 #include "arm/sgemv.h"
+#include "arm/sparse.h"
 
 #include <assert.h>
 #include <stdio.h>
+#include <vector>
 
 namespace feather
 {
+/*
+ * With sparse set the weights are kept as 4x1 blocks, the zero ones skipped. With int8_weights
+ * they are quantized per output and the fp32 copy is released. Both modes apply bias and a
+ * following ReLU in the kernel.
+ */
 class InnerProductLayer : public Layer
 {
     public:
-        InnerProductLayer(const LayerParameter *layer_param, const RuntimeParameter<float>* rt_param)
-            : Layer(layer_param, rt_param)
+        InnerProductLayer(const LayerParameter *layer_param, const RuntimeParameter<float>* rt_param, bool sparse = false, bool int8_weights = false)
+            : sparse(sparse), int8_weights(int8_weights), fuse_relu(false), Layer(layer_param, rt_param)
         {
             //From proto
             const InnerProductParameter *inner_product_param = layer_param->inner_product_param();
@@ -42,6 +49,17 @@ class InnerProductLayer : public Layer
                 assert(this->_weight_blobs.size() == 2);
                 bias_data = this->_weight_blobs[1]->data();
             }
+            _fusible = sparse || int8_weights;
+        }
+
+        int Fuse(Layer *next_layer)
+        {
+            if (_fusible && next_layer->type().compare("ReLU") == 0)
+            {
+                fuse_relu = true;
+                return 1;
+            }
+            return 0;
         }
 
         int Forward()
@@ -49,6 +67,16 @@ class InnerProductLayer : public Layer
             const float *input = _bottom_blobs[_bottom[0]]->data();
             float *output = _top_blobs[_top[0]]->data();
 
+            if (sparse)
+            {
+                sparse_sgemv(sparse_kernel, input, output, bias_data, num_threads);
+                return 0;
+            }
+            if (int8_weights)
+            {
+                int8_sgemv((int)input_size, (int)output_size, input, &quantized_kernel[0], &kernel_scales[0], output, bias_data, num_threads);
+                return 0;
+            }
             if (output_size % 8 == 0 && input_size % 8 == 0)
                 fully_connected_transpose_inference_neon8((int)input_size, (int)output_size, input, kernel_data, output, num_threads);
             else
@@ -76,6 +104,37 @@ class InnerProductLayer : public Layer
 
         int Init()
         {
+            if (sparse)
+            {
+                block_sparse_encode(&sparse_kernel, kernel_data, output_size, input_size);
+                if (bias_term && fuse_relu)
+                    sparse_sgemv = block_sparse_sgemv<true, true>;
+                else if (bias_term)
+                    sparse_sgemv = block_sparse_sgemv<true, false>;
+                else if (fuse_relu)
+                    sparse_sgemv = block_sparse_sgemv<false, true>;
+                else
+                    sparse_sgemv = block_sparse_sgemv<false, false>;
+                return 0;
+            }
+            if (int8_weights)
+            {
+                quantized_kernel.resize(output_size * input_size);
+                kernel_scales.resize(output_size);
+                quantize_rows_int8(&quantized_kernel[0], &kernel_scales[0], kernel_data, output_size, input_size);
+                //Only the int8 copy is read from now on.
+                _weight_blobs[0]->Free();
+                kernel_data = NULL;
+                if (bias_term && fuse_relu)
+                    int8_sgemv = fully_connected_inference_int8<true, true>;
+                else if (bias_term)
+                    int8_sgemv = fully_connected_inference_int8<true, false>;
+                else if (fuse_relu)
+                    int8_sgemv = fully_connected_inference_int8<false, true>;
+                else
+                    int8_sgemv = fully_connected_inference_int8<false, false>;
+                return 0;
+            }
             float* buffer = NULL;
             MEMPOOL_CHECK_RETURN(private_mempool.Alloc(&buffer, sizeof(float) * input_size * 8));
             if (input_size % 8 == 0 && output_size % 8 == 0)
@@ -120,5 +179,15 @@ class InnerProductLayer : public Layer
 
         float *kernel_data;
         float *bias_data;
+
+        bool sparse;
+        bool fuse_relu;
+        BlockSparseMatrix sparse_kernel;
+        void (*sparse_sgemv)(const BlockSparseMatrix& a, const float* x, float* y, const float* bias, const int num_threads);
+
+        bool int8_weights;
+        std::vector<int8_t> quantized_kernel;
+        std::vector<float> kernel_scales;
+        void (*int8_sgemv)(const int input_size, const int output_size, const float *x, const int8_t *y, const float *scales, float *z, const float *bias, const int num_threads);
 };
 };
@@ -21,6 +21,7 @@
 #include <stdio.h>
 
 #include <map>
+#include <set>
 
 namespace feather
 {
@@ -65,7 +66,28 @@ class InputLayer : public Layer
             return 0;
         }
 
-        int CopyInput(std::string name, float *input_data)
+        //Makes the input a view of data holding height x width maps, nothing is copied.
+        int BindInput(std::string name, float *data, int height, int width)
+        {
+            Blob<float> *p_blob = _top_blobs[name];
+            p_blob->BindData(data, p_blob->num() * p_blob->channels() * height * width);
+            p_blob->ReshapeWithRealloc(p_blob->num(), p_blob->channels(), height, width);
+            bound_inputs.insert(name);
+            return 0;
+        }
+
+        //Gives a bound input its own memory again, returns whether it was bound.
+        bool UnbindInput(std::string name)
+        {
+            if (bound_inputs.erase(name) == 0)
+                return false;
+            Blob<float> *p_blob = _top_blobs[name];
+            p_blob->Free();
+            p_blob->Realloc(p_blob->data_size());
+            return true;
+        }
+
+        int CopyInput(std::string name, const float *input_data)
         {
             _top_blobs[name]->CopyData(input_data);
             return 0;
@@ -82,9 +104,11 @@ class InputLayer : public Layer
             return _top_blobs.size();
         }
 
+        //NULL if the net has no such input.
         const Blob<float> *input_blob(std::string name)
         {
-            return _top_blobs[name];
+            std::map<std::string, Blob<float> *>::iterator it = _top_blobs.find(name);
+            return (it == _top_blobs.end()) ? NULL : it->second;
         }
 
         std::string input_name(int idx)
@@ -96,5 +120,8 @@ class InputLayer : public Layer
             }
             return it->first;
         }
+
+    private:
+        std::set<std::string> bound_inputs;
 };
 };
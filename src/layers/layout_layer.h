@@ -0,0 +1,52 @@
+//Tencent is pleased to support the open source community by making FeatherCNN available.
+
+//Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+
+//Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+//in compliance with the License. You may obtain a copy of the License at
+//
+//https://opensource.org/licenses/BSD-3-Clause
+//
+//Unless required by applicable law or agreed to in writing, software distributed
+//under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//CONDITIONS OF ANY KIND, either express or implied. See the License for the
+//specific language governing permissions and limitations under the License.
+
+#pragma once
+
+#include "../layer.h"
+#include "arm/generic_kernels.h"
+
+namespace feather
+{
+//Converts a blob between NCHW and NC4HW4, inserted by the net where layers of both kinds meet.
+class LayoutLayer : public Layer
+{
+    public:
+        LayoutLayer(const std::string &name, const std::string &bottom, const Blob<float> *bottom_blob,
+                    const std::string &top, BlobLayout layout, const RuntimeParameter<float>* rt_param)
+            : Layer(name, "Layout", rt_param)
+        {
+            _bottom.push_back(bottom);
+            _top.push_back(top);
+            SetupBottomBlob(bottom_blob, bottom);
+            Blob<float> *p_blob = new Blob<float>();
+            p_blob->CopyShape(bottom_blob);
+            p_blob->set_layout(layout);
+            p_blob->Alloc();
+            _top_blobs[top] = p_blob;
+        }
+
+        int Forward()
+        {
+            const Blob<float> *p_bottom = _bottom_blobs[_bottom[0]];
+            const Blob<float> *p_top = _top_blobs[_top[0]];
+            const size_t stride = p_bottom->height() * p_bottom->width();
+            if (p_top->layout() == NC4HW4)
+                pack_nc4hw4(p_top->data(), p_bottom->data(), p_bottom->channels(), stride, num_threads);
+            else
+                unpack_nc4hw4(p_top->data(), p_bottom->data(), p_bottom->channels(), stride, num_threads);
+            return 0;
+        }
+};
+};
@@ -19,26 +19,27 @@
 
 namespace feather
 {
+/*
+ * Caffe's local response normalization. ACROSS_CHANNELS slides a window over the channels,
+ * WITHIN_CHANNEL a local_size x local_size box over each map, using per-thread row buffers
+ * from the common mempool.
+ */
 class LRNLayer : public Layer
 {
     public:
         LRNLayer(const LayerParameter* layer_param, const RuntimeParameter<float>* rt_param);
         int Forward();
+        int ForwardReshape();
         int Init();
     private:
-        //int CompSquare();
-        int AcrossChannels();
+        size_t ScratchSize();
+
         size_t local_size;
         float alpha;
-        float alpha_over_size;
         float beta;
         float k;
+        bool within_channel;
 
-        size_t _pre_pad;
-        float* _square;
-        float* _square_sum;
-
-        float* _scale_data;
-        float* _padded_sqr_data;
+        float* buffer;
 };
 };
@@ -16,6 +16,8 @@
 
 #include "../feather_simple_generated.h"
 #include "../layer.h"
+#include "arm/pooling.h"
+#include "arm/helper.h"
 
 #include <math.h>
 #include <limits>
@@ -92,55 +94,22 @@ class PoolingLayer : public Layer
 
         int Forward()
         {
-            fprintf(stderr, "Pooling layer %s\ninput shape %ld %ld %ld kernel shape %ld %ld stride %ld %ld\n", this->name().c_str(), input_channels, input_height, input_width, kernel_height, kernel_width, stride_height, stride_width);
-            fprintf(stderr, "output (%d %d)\n", output_height, output_width);
+#ifdef LAYER_TIMING
+            LOGD("Pooling layer %s input (%zu %zu %zu) kernel (%zu %zu) stride (%zu %zu) output (%zu %zu)\n", this->name().c_str(),
+                 input_channels, input_height, input_width, kernel_height, kernel_width, stride_height, stride_width, output_height, output_width);
+#endif
             const float *input = _bottom_blobs[_bottom[0]]->data();
             float *output = _top_blobs[_top[0]]->data();
-            float *p = output;
-
-            int slot = input_channels * output_height;
-
-            #pragma omp parallel for schedule(static) num_threads(num_threads)
-//  for (int u=0;u<slot;u++)
-//  {
-            for (int i = 0; i < input_channels; ++i)
+            if (_bottom_blobs[_bottom[0]]->layout() == NC4HW4)
             {
-                for (int j = 0; j < output_height; j ++)
-                {
-//    int i=slot/output_height,  j=slot%output_height;
-                    float *p = output + i * output_height * output_width + j * output_width;
-                    for (int l = 0; l < output_width; l++)  p[l] = (this->method != PoolingParameter_::PoolMethod_MAX_ ? 0 : -1 * std::numeric_limits<float>::max()) ;
-
-                    int tmp_pos = j * (int)stride_height - (int)pad_height;
-                    int x_min = MAX(tmp_pos, 0);
-                    int x_max = MIN((int)(tmp_pos + kernel_height), (int) input_height);
-
-		    for (int k = 0; k < output_width; k ++)
-		    {
-			    int counter = 0;
-			    float total = (this->method != PoolingParameter_::PoolMethod_MAX_ ? 0 : -1 * std::numeric_limits<float>::max());
-			    for (int x = x_min; x < x_max; ++x)
-			    {
-				    int xpos = i * input_height * input_width + x * input_width;
-
-
-				    int local_pos = k * (int)stride_width - (int)pad_width;
-				    int y_min     = MAX(local_pos, 0);
-				    int y_max     = MIN((int)(local_pos + kernel_width), (int) input_width);
-
-				    for (int y = y_min; y < y_max; ++y)
-				    {
-					    float value = input[xpos + y];
-					    if (this->method != PoolingParameter_::PoolMethod_MAX_)        total += value, counter++;
-					    else                                          total = total > value ? total : value;
-				    }
-			    }
-			    if (this->method != PoolingParameter_::PoolMethod_MAX_)
-				    p[k] += total / (counter);
-			    else    p[k]  = (p[k] > total) ? p[k] : total;
-		    }
-                }
+                pooling_nc4hw4(output, input, this->method == PoolingParameter_::PoolMethod_MAX_, input_channels,
+                               input_height, input_width, output_height, output_width,
+                               kernel_height, kernel_width, stride_height, stride_width, pad_height, pad_width, num_threads);
+                return 0;
             }
+            pooling_rows(output, input, this->method == PoolingParameter_::PoolMethod_MAX_, input_channels,
+                         input_height, input_width, 0, input_height, output_height, output_width, 0, output_height,
+                         kernel_height, kernel_width, stride_height, stride_width, pad_height, pad_width, num_threads);
             return 0;
         }
        
@@ -201,6 +170,27 @@ class PoolingLayer : public Layer
             return 0;
         }
 
+        bool SupportsPackedLayout()
+        {
+            return true;
+        }
+
+        //Window accessors for producers fusing this pooling into their output stage.
+        bool is_max_pooling() const
+        {
+            return this->method == PoolingParameter_::PoolMethod_MAX_;
+        }
+        bool is_global_pooling() const
+        {
+            return global_pooling;
+        }
+        size_t window_h() const { return kernel_height; }
+        size_t window_w() const { return kernel_width; }
+        size_t window_stride_h() const { return stride_height; }
+        size_t window_stride_w() const { return stride_width; }
+        size_t window_pad_h() const { return pad_height; }
+        size_t window_pad_w() const { return pad_width; }
+
     private:
         size_t input_height;
         size_t input_width;
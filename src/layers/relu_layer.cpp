@@ -21,7 +21,7 @@ int ReluLayer::Forward()
 {
     const Blob<float> *p_bottom = _bottom_blobs[_bottom[0]];
     const float* input = p_bottom->data();
-    const size_t data_size = p_bottom->num() * p_bottom->channels() * p_bottom->height() * p_bottom->width();
+    const size_t data_size = p_bottom->data_size();
 
     float* output = _top_blobs[_top[0]]->data();
     for (size_t i = 0; i < data_size; ++i)
@@ -27,5 +27,9 @@ class ReluLayer : public Layer
         {
         }
         int Forward();
+        bool SupportsPackedLayout()
+        {
+            return true;
+        }
 };
 };
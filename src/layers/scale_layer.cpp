@@ -19,9 +19,16 @@ namespace feather
 {
 int ScaleLayer::Forward()
 {
-    const float* input = _bottom_blobs[_bottom[0]]->data();
+    const Blob<float> *p_blob = _bottom_blobs[_bottom[0]];
+    const float* input = p_blob->data();
     float* output = _top_blobs[_top[0]]->data();
-    size_t stride = input_width * input_height;
+    //Taken from the bottom blob so that ForwardReshape sees the new size.
+    size_t stride = p_blob->width() * p_blob->height();
+    if (packed_scale)
+    {
+        affine_nc4hw4<false>(input_channels, stride, packed_scale, packed_bias, input, output, num_threads);
+        return 0;
+    }
     scale_kernel(input_channels, stride, bias_data, scale_data, input, output, num_threads);
     return 0;
 }
@@ -45,6 +52,17 @@ int ScaleLayer::Init()
     {
         scale_kernel = scale<false>;
     }
+    if (p_blob->layout() == NC4HW4)
+    {
+        size_t aligned_channels = p_blob->aligned_channels();
+        MEMPOOL_CHECK_RETURN(private_mempool.Alloc(&packed_scale, aligned_channels * sizeof(float)));
+        MEMPOOL_CHECK_RETURN(private_mempool.Alloc(&packed_bias, aligned_channels * sizeof(float)));
+        for (int i = 0; i < aligned_channels; i++)
+        {
+            packed_scale[i] = (i < input_channels) ? scale_data[i] : 0.f;
+            packed_bias[i] = (i < input_channels && _bias_term) ? bias_data[i] : 0.f;
+        }
+    }
     return 0;
 }
 };
@@ -29,6 +29,8 @@ class ScaleLayer : public Layer
               scale_data(NULL),
               _bias_term(false),
               bias_data(NULL),
+              packed_scale(NULL),
+              packed_bias(NULL),
               Layer(layer_param, rt_param)
         {
             _bias_term = layer_param->scale_param()->bias_term();
@@ -36,6 +38,10 @@ class ScaleLayer : public Layer
 
         int Forward();
         int Init();
+        bool SupportsPackedLayout()
+        {
+            return true;
+        }
 
         bool bias_term()
         {
@@ -50,6 +56,10 @@ class ScaleLayer : public Layer
         bool _bias_term;
         float* bias_data;
 
+        //Zero padded copies for NC4HW4 inputs.
+        float* packed_scale;
+        float* packed_bias;
+
     private:
         void (*scale_kernel)(const size_t channels, const size_t stride, const  float* bias_data, const float* scale_data, const float* input, float* output, const size_t num_threads);
 };
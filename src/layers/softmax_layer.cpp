@@ -13,9 +13,8 @@
 //specific language governing permissions and limitations under the License.
 
 #include "softmax_layer.h"
-#include "arm/generic_kernels.h"
-
-#include <math.h>
+#include "argmax_layer.h"
+#include "arm/softmax.h"
 
 namespace feather
 {
@@ -24,19 +23,69 @@ int SoftmaxLayer::Forward()
 {
     const Blob<float> *p_bottom = _bottom_blobs[_bottom[0]];
     const float* input = p_bottom->data();
-    const size_t data_size = p_bottom->num() * p_bottom->channels() * p_bottom->height() * p_bottom->width();
     float* output = _top_blobs[_top[0]]->data();
+    size_t outer, n, inner;
+    if (fuse_topk)
+    {
+        //Flattened ArgMax fuses only when the softmax spans the whole blob.
+        SplitAtAxis(p_bottom, flatten ? 1 : axis, &outer, &n, &inner);
+        if (flatten)
+            topk(output, out_max_val ? output + top_k : NULL, input, 1, n, 1, top_k, true, num_threads);
+        else
+            topk(out_max_val ? NULL : output, out_max_val ? output : NULL, input, outer, n, inner, top_k, true, num_threads);
+        return 0;
+    }
+    SplitAtAxis(p_bottom, axis, &outer, &n, &inner);
+    softmax(output, input, outer, n, inner, num_threads);
+    return 0;
+}
 
-    float sum = 0.0;
-    for (size_t i = 0; i < data_size; ++i)
+int SoftmaxLayer::ForwardReshape()
+{
+    const Blob<float> *p_bottom = _bottom_blobs[_bottom[0]];
+    if (fuse_topk)
     {
-        output[i] = static_cast<float>(exp(input[i]));
-        sum += output[i];
+        const size_t n = ArgMaxLayer::ReducedSize(p_bottom, flatten ? 0 : axis);
+        if (top_k > n)
+        {
+            LOGE("Softmax %s: top_k %zu of the fused ArgMax exceeds the %zu elements\n", _name.c_str(), top_k, n);
+            return -1;
+        }
+        size_t shape[4];
+        ArgMaxLayer::TopShape(p_bottom, flatten ? 0 : axis, top_k, out_max_val, shape);
+        _top_blobs[_top[0]]->ReshapeWithRealloc(shape[0], shape[1], shape[2], shape[3]);
     }
-    for (size_t i = 0; i < data_size; ++i)
+    else
+        _top_blobs[_top[0]]->ReshapeWithRealloc(p_bottom);
+    return Forward();
+}
+
+int SoftmaxLayer::Fuse(Layer* next_layer)
+{
+    if (fuse_topk || next_layer->type().compare("ArgMax") != 0)
+        return 0;
+    const ArgMaxLayer* argmax_layer = (const ArgMaxLayer*) next_layer;
+    const Blob<float>* p_bottom = _bottom_blobs[_bottom[0]];
+    size_t outer, n, inner;
+    SplitAtAxis(p_bottom, axis, &outer, &n, &inner);
+    //The ArgMax has to reduce over the softmax axis: either the same axis or the whole blob of a 1D softmax.
+    if (argmax_layer->is_flattened())
     {
-        output[i] = output[i] / sum;
+        if (outer != 1 || inner != 1)
+            return 0;
+        flatten = true;
     }
-    return 0;
+    else
+    {
+        int argmax_axis = argmax_layer->reduce_axis();
+        if ((argmax_axis < 0 ? argmax_axis + 4 : argmax_axis) != (axis < 0 ? axis + 4 : axis))
+            return 0;
+        flatten = false;
+    }
+    top_k = argmax_layer->k();
+    out_max_val = argmax_layer->outputs_max_val();
+    fuse_topk = true;
+    TakeOverTop(next_layer);
+    return 1;
 }
 };
@@ -19,13 +19,40 @@
 
 namespace feather
 {
+//Splits a blob into outer x n x inner around the given axis of (num, channels, height, width), negative axes count from the end.
+inline void SplitAtAxis(const Blob<float>* p_blob, int axis, size_t* outer, size_t* n, size_t* inner)
+{
+    const size_t dims[4] = {p_blob->num(), p_blob->channels(), p_blob->height(), p_blob->width()};
+    axis = (axis < 0) ? axis + 4 : axis;
+    *outer = 1;
+    *inner = 1;
+    for (int i = 0; i < axis; ++i)
+        *outer *= dims[i];
+    for (int i = axis + 1; i < 4; ++i)
+        *inner *= dims[i];
+    *n = dims[axis];
+}
+
 class SoftmaxLayer : public Layer
 {
     public:
         SoftmaxLayer(const LayerParameter* layer_param, const RuntimeParameter<float>* rt_param)
-            : Layer(layer_param, rt_param)
+            : axis(1), fuse_topk(false), Layer(layer_param, rt_param)
         {
+            _fusible = true;
+            if (layer_param->softmax_param())
+                axis = layer_param->softmax_param()->axis();
         }
         int Forward();
+        int ForwardReshape();
+        int Fuse(Layer* next_layer);
+
+    private:
+        int axis;
+        //A following ArgMax is computed from the logits, the probability map is never written.
+        bool fuse_topk;
+        size_t top_k;
+        bool out_max_val;
+        bool flatten;
 };
 };
@@ -33,12 +33,23 @@ CommonMemPool<PTR_TYPE>::~CommonMemPool()
 template<typename PTR_TYPE>
 bool CommonMemPool<PTR_TYPE>::Alloc()
 {
-    if (common_memory)
+    if (common_memory && attached_size == 0)
     {
         fprintf(stderr, "Error: common memory already allocated.\n");
         return false;
     }
-    if (common_size > 0)
+    if (common_memory)
+    {
+        if (common_size <= attached_size)
+            common_size = attached_size;
+        else
+        {
+            //Outgrown, fall back to an allocation of our own.
+            common_memory = NULL;
+            attached_size = 0;
+        }
+    }
+    if (common_size > 0 && !common_memory)
     {
         common_memory = (PTR_TYPE *) _mm_malloc(common_size, 128);
         if (!common_memory)
@@ -71,7 +82,9 @@ bool CommonMemPool<PTR_TYPE>::Alloc(size_t size_byte)
 {
     if(size_byte > common_size)
     {
-        free(common_memory);
+        if (attached_size == 0)
+            free(common_memory);
+        attached_size = 0;
         common_memory = NULL;
         common_size = size_byte;
         common_memory = (PTR_TYPE *) _mm_malloc(common_size, 128);
@@ -86,13 +99,30 @@ bool CommonMemPool<PTR_TYPE>::Free()
 {
     if (common_memory)
     {
-        free(common_memory);
+        if (attached_size == 0)
+            free(common_memory);
+        attached_size = 0;
         common_size = 0;
         common_memory = NULL;
     }
     return true;
 }
 
+template<typename PTR_TYPE>
+bool CommonMemPool<PTR_TYPE>::Attach(PTR_TYPE *ptr, size_t size_byte)
+{
+    if (common_memory)
+    {
+        //Swapped in between runs, larger requests allocate again with Alloc(size_byte).
+        if (attached_size == 0)
+            free(common_memory);
+        common_size = size_byte;
+    }
+    common_memory = ptr;
+    attached_size = size_byte;
+    return true;
+}
+
 template<typename PTR_TYPE>
 bool CommonMemPool<PTR_TYPE>::Free(size_t id)
 {
@@ -23,13 +23,20 @@ template<typename PTR_TYPE>
 class CommonMemPool
 {
     public:
-        CommonMemPool(): common_size(0), common_memory(NULL) {}
+        CommonMemPool(): common_size(0), common_memory(NULL), attached_size(0) {}
         ~CommonMemPool();
 
         //Single common memory pool
         bool Request(size_t size_byte);
         bool GetPtr(PTR_TYPE ** ptr);
         bool Free();
+        //Serve the default pool from memory owned by the caller, as long as the requests fit in it.
+        //Memory the pool allocated itself is released.
+        bool Attach(PTR_TYPE *ptr, size_t size_byte);
+        size_t GetSize() const
+        {
+            return common_size;
+        }
 
         //Multiple common pools by ID
         bool Request(size_t size_byte, size_t id);
@@ -45,6 +52,8 @@ class CommonMemPool
         //Default common memory pool
         size_t common_size;
         PTR_TYPE * common_memory;
+        //Non-zero while common_memory is attached.
+        size_t attached_size;
 
         //Map common ID to size
         std::map<size_t, size_t> common_size_map;
@@ -17,17 +17,315 @@
 #include "net.h"
 #include "layer.h"
 #include "layers/input_layer.h"
+#include "layers/layout_layer.h"
 #include "mempool.h"
+#include "common.h"
 
 #include "arm/helper.h"
 
 #include <stdio.h>
+#include <stdint.h>
+#include <math.h>
 #include <cstring>
+#include <algorithm>
+#include <set>
+
+#ifdef __APPLE__
+#else
+#include <omp.h>
+#endif
 // #define LAYER_TIMING
 
 namespace feather
 {
+/*
+ * Walks the layer list backwards from the target blobs and flags every layer
+ * producing a blob on the way. A top is consumed before the bottoms are added,
+ * so in-place layers keep their blob name alive for the earlier producer.
+ * Returns false if a target blob is produced by none of the layers.
+ */
+static bool MarkRequiredLayers(const std::vector<std::vector<std::string> > &bottoms,
+                               const std::vector<std::vector<std::string> > &tops,
+                               const std::vector<std::string> &targets,
+                               std::vector<bool> &required)
+{
+    std::set<std::string> wanted(targets.begin(), targets.end());
+    std::set<std::string> found;
+    required.assign(tops.size(), false);
+    for (int i = (int)tops.size() - 1; i >= 0; --i)
+    {
+        for (size_t t = 0; t < tops[i].size(); ++t)
+        {
+            if (wanted.find(tops[i][t]) != wanted.end())
+                required[i] = true;
+        }
+        if (!required[i])
+            continue;
+        for (size_t t = 0; t < tops[i].size(); ++t)
+        {
+            wanted.erase(tops[i][t]);
+            found.insert(tops[i][t]);
+        }
+        for (size_t b = 0; b < bottoms[i].size(); ++b)
+            wanted.insert(bottoms[i][b]);
+    }
+    for (size_t i = 0; i < targets.size(); ++i)
+    {
+        if (found.find(targets[i]) == found.end())
+        {
+            LOGE("Requested blob %s is not produced by any layer\n", targets[i].c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * A layer may only absorb a consumer of its top blob if nothing else reads that blob,
+ * otherwise the other readers would see the fused result. An in-place consumer redefines
+ * the blob, so the layers after it read the fused output legitimately.
+ */
+static bool IsSoleConsumer(std::vector<Layer *> &layers, size_t producer, size_t consumer, const std::string &blob_name)
+{
+    for (size_t k = producer + 1; k < layers.size(); ++k)
+    {
+        bool redefines = false;
+        for (size_t t = 0; t < layers[k]->top_size(); ++t)
+        {
+            if (layers[k]->top(t).compare(blob_name) == 0)
+                redefines = true;
+        }
+        if (k == consumer)
+        {
+            if (redefines)
+                return true;
+            continue;
+        }
+        for (size_t b = 0; b < layers[k]->bottom_size(); ++b)
+        {
+            if (layers[k]->bottom(b).compare(blob_name) == 0)
+                return false;
+        }
+        if (redefines)
+            return k > consumer;
+    }
+    return true;
+}
+
+/*
+ * Runs every layer supporting it on NC4HW4 and inserts a LayoutLayer wherever a bottom
+ * arrives in the other layout. A converted blob is shared by all its consumers.
+ */
+static void PlanPackedLayout(std::vector<Layer *> &layers, const RuntimeParameter<float> *rt_param)
+{
+    std::map<const Blob<float> *, const Blob<float> *> converted;
+    for (size_t i = 1; i < layers.size(); ++i)
+    {
+        Layer *layer = layers[i];
+        BlobLayout layout = layer->SupportsPackedLayout() ? NC4HW4 : NCHW;
+        for (size_t b = 0; b < layer->bottom_size(); ++b)
+        {
+            std::string name = layer->bottom(b);
+            const Blob<float> *p_blob = layer->bottom_blob(b);
+            if (p_blob == NULL || p_blob->layout() == layout)
+                continue;
+            std::string new_name = name + ((layout == NC4HW4) ? "_nc4hw4" : "_nchw");
+            if (converted.find(p_blob) == converted.end())
+            {
+                Layer *layout_layer = new LayoutLayer(new_name, name, p_blob, new_name, layout, rt_param);
+                layers.insert(layers.begin() + i, layout_layer);
+                ++i;
+                converted[p_blob] = layout_layer->top_blob(0);
+            }
+            layer->ReplaceBottomBlob(name, new_name, converted[p_blob]);
+        }
+        if (layout == NC4HW4)
+            layer->SetTopLayout(NC4HW4);
+    }
+}
+
+/*
+ * Every top blob with the span of layers it has to survive: from its producer to its last
+ * reader, or to the end of the net for blobs nobody reads after their last write and kept
+ * blobs. In-place layers write the blob of their bottom, which keeps the single entry of
+ * its producer.
+ */
+struct BlobLifetime
+{
+    Layer *layer;
+    size_t top;
+    Blob<float> *blob;
+    size_t first;
+    size_t last;
+    size_t size;
+};
+
+//Arena slots start on cache lines.
+static const size_t kArenaAlign = 64;
+
+static void CollectBlobLifetimes(std::vector<Layer *> &layers, const std::set<const Blob<float> *> &kept,
+                                 std::vector<BlobLifetime> &lifetimes)
+{
+    lifetimes.clear();
+    std::set<const Blob<float> *> seen;
+    for (size_t i = 0; i < layers.size(); ++i)
+    {
+        for (size_t t = 0; t < layers[i]->top_size(); ++t)
+        {
+            BlobLifetime lifetime;
+            lifetime.layer = layers[i];
+            lifetime.top = t;
+            //The net owns the blobs, layers only hand them out read-only.
+            lifetime.blob = const_cast<Blob<float> *>(layers[i]->top_blob(t));
+            if (!seen.insert(lifetime.blob).second)
+                continue;
+            lifetime.first = i;
+            size_t last_write = i;
+            size_t last_read = i;
+            for (size_t k = i + 1; k < layers.size(); ++k)
+            {
+                for (size_t b = 0; b < layers[k]->bottom_size(); ++b)
+                {
+                    if (layers[k]->bottom_blob(b) == lifetime.blob)
+                        last_read = k;
+                }
+                for (size_t b = 0; b < layers[k]->top_size(); ++b)
+                {
+                    if (layers[k]->top_blob(b) == lifetime.blob)
+                        last_write = k;
+                }
+            }
+            lifetime.last = last_read;
+            if (last_read <= last_write || kept.find(lifetime.blob) != kept.end())
+                lifetime.last = layers.size();
+            lifetime.size = (lifetime.blob->capacity() * sizeof(float) + kArenaAlign - 1) / kArenaAlign * kArenaAlign;
+            lifetimes.push_back(lifetime);
+        }
+    }
+}
+
+static bool LifetimesOverlap(const BlobLifetime &a, const BlobLifetime &b)
+{
+    return a.first <= b.last && b.first <= a.last;
+}
+
+static bool LargerBlob(const BlobLifetime *a, const BlobLifetime *b)
+{
+    return (a->size != b->size) ? a->size > b->size : a->first < b->first;
+}
+
+/*
+ * Greedy by size: the largest blobs are placed first, each at the lowest offset
+ * not taken by an already placed blob alive at the same time. Returns the arena size.
+ */
+static size_t PlaceBlobs(const std::vector<BlobLifetime> &lifetimes, std::vector<size_t> &offsets)
+{
+    std::vector<const BlobLifetime *> order;
+    for (size_t i = 0; i < lifetimes.size(); ++i)
+        order.push_back(&lifetimes[i]);
+    std::sort(order.begin(), order.end(), LargerBlob);
+
+    std::map<const BlobLifetime *, size_t> placed;
+    size_t arena_size = 0;
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        std::vector<std::pair<size_t, size_t> > taken;
+        for (size_t j = 0; j < i; ++j)
+        {
+            if (LifetimesOverlap(*order[i], *order[j]))
+                taken.push_back(std::make_pair(placed[order[j]], order[j]->size));
+        }
+        std::sort(taken.begin(), taken.end());
+        size_t offset = 0;
+        for (size_t j = 0; j < taken.size(); ++j)
+        {
+            if (offset + order[i]->size <= taken[j].first)
+                break;
+            offset = std::max(offset, taken[j].first + taken[j].second);
+        }
+        placed[order[i]] = offset;
+        arena_size = std::max(arena_size, offset + order[i]->size);
+    }
+    offsets.clear();
+    for (size_t i = 0; i < lifetimes.size(); ++i)
+        offsets.push_back(placed[&lifetimes[i]]);
+    return arena_size;
+}
+
+/*
+ * Layers each layer has to wait for: the last writers of its bottoms and, for the blobs it
+ * writes, the last writer and the readers since, so that in-place layers don't overwrite data
+ * still being read. The input layer runs before everything else and is left out.
+ */
+static void CollectLayerDependencies(std::vector<Layer *> &layers, std::vector<std::set<size_t> > &deps)
+{
+    std::map<std::string, size_t> writer;
+    std::map<std::string, std::vector<size_t> > readers;
+    deps.assign(layers.size(), std::set<size_t>());
+    for (size_t i = 1; i < layers.size(); ++i)
+    {
+        for (size_t b = 0; b < layers[i]->bottom_size(); ++b)
+        {
+            std::map<std::string, size_t>::iterator it = writer.find(layers[i]->bottom(b));
+            if (it != writer.end())
+                deps[i].insert(it->second);
+        }
+        for (size_t t = 0; t < layers[i]->top_size(); ++t)
+        {
+            std::map<std::string, size_t>::iterator it = writer.find(layers[i]->top(t));
+            if (it != writer.end())
+                deps[i].insert(it->second);
+            const std::vector<size_t> &previous = readers[layers[i]->top(t)];
+            deps[i].insert(previous.begin(), previous.end());
+        }
+        for (size_t b = 0; b < layers[i]->bottom_size(); ++b)
+            readers[layers[i]->bottom(b)].push_back(i);
+        for (size_t t = 0; t < layers[i]->top_size(); ++t)
+        {
+            writer[layers[i]->top(t)] = i;
+            readers[layers[i]->top(t)].clear();
+        }
+    }
+}
+
+//Rough multiply-adds of a layer: each top element costs the weights per output channel, or one without weights.
+static double EstimateFlops(Layer *layer)
+{
+    double elements = 0;
+    for (size_t t = 0; t < layer->top_size(); ++t)
+        elements += layer->top_blob(t)->data_size();
+    double per_element = 1;
+    if (layer->weight_blob_num() > 0 && layer->top_size() > 0 && layer->top_blob(0)->channels() > 0)
+        per_element = std::max(1.0, (double) layer->weight_blob(0)->data_size() / layer->top_blob(0)->channels());
+    return elements * per_element;
+}
+
+//One thread per lane, each further thread goes to the lane with the most work per thread.
+static void SplitThreads(const std::vector<double> &costs, size_t num_threads, std::vector<size_t> &threads)
+{
+    threads.assign(costs.size(), 1);
+    for (size_t n = costs.size(); n < num_threads; ++n)
+    {
+        size_t busiest = 0;
+        for (size_t l = 1; l < costs.size(); ++l)
+        {
+            if (costs[l] / threads[l] > costs[busiest] / threads[busiest])
+                busiest = l;
+        }
+        ++threads[busiest];
+    }
+}
+
 Net::Net(size_t num_threads)
+    : packed_layout(false),
+      arena(NULL),
+      blobs_moved(false),
+      concurrent_branches(false),
+      pipeline_depth(0),
+      max_plans(4),
+      plan_clock(0),
+      active_plan(NULL),
+      reserved_threads(num_threads)
 {
     register_layer_creators();
     CommonMemPool<float> *mempool = new CommonMemPool<float>();
@@ -42,7 +340,28 @@ Net::~Net()
         delete layers[i];
     }
     delete rt_param->common_mempool();
+    for (size_t i = 0; i < lane_mempools.size(); ++i)
+        delete lane_mempools[i];
+    for (size_t i = 0; i < stage_copies.size(); ++i)
+        delete stage_copies[i].blob;
     delete rt_param;
+    if (arena)
+        free(arena);
+    std::map<std::vector<size_t>, ResolutionPlan>::iterator it;
+    for (it = resolution_plans.begin(); it != resolution_plans.end(); ++it)
+        free(it->second.arena);
+}
+
+//Alignment of the blobs the net allocates itself, required from bound caller buffers.
+static const size_t kBindAlign = 32;
+
+//Copies a blob out in NCHW.
+static void CopyBlobData(float *output_ptr, const Blob<float> *p_blob, size_t num_threads)
+{
+    if (p_blob->layout() == NC4HW4)
+        unpack_nc4hw4(output_ptr, p_blob->data(), p_blob->channels(), p_blob->height() * p_blob->width(), num_threads);
+    else
+        memcpy(output_ptr, p_blob->data(), sizeof(float) * p_blob->data_size());
 }
 
 int Net::ExtractBlob(float* output_ptr, std::string name)
@@ -52,32 +371,92 @@ int Net::ExtractBlob(float* output_ptr, std::string name)
         LOGE("Cannot find blob %s\n", name.c_str());
         return -1;
     }
-    const Blob<float> *p_blob = blob_map[name];
-    const size_t data_size = p_blob->data_size();
-    const float *data = p_blob->data();
-
-    memcpy(output_ptr, data, sizeof(float) * data_size);
+    CopyBlobData(output_ptr, blob_map[name], rt_param->num_threads());
     return 0;
 }
 
 int Net::PrintBlobData(std::string blob_name)
 {
-    size_t data_size;
-    this->GetBlobDataSize(&data_size, blob_name);
-    float *arr = (float*) malloc(sizeof(float) * data_size);
-    this->ExtractBlob(arr, blob_name);
-    size_t len = data_size;
-
-    for (int i = 0; i < len; ++i)
+    BlobView view;
+    if (GetBlobView(blob_name, &view) != 0)
+        return -1;
+    const size_t plane = view.height * view.width;
+    for (size_t c = 0; c < view.num * view.channels; ++c)
     {
-        LOGD("%f\t", arr[i]);
+        for (size_t i = 0; i < plane; ++i)
+        {
+            size_t index = (view.layout == NC4HW4) ? ((c / 4 * plane + i) * 4 + c % 4) : (c * plane + i);
+            LOGD("%f\t", view.data[index]);
+        }
     }
     LOGD("\n");
-    free(arr);
-	
     return 0;
 }
 
+const Blob<float> *Net::GetBlobHandle(const std::string &name)
+{
+    std::map<std::string, const Blob<float> *>::iterator it = blob_map.find(name);
+    return (it == blob_map.end()) ? NULL : it->second;
+}
+
+BlobView Net::GetBlobView(const Blob<float> *blob)
+{
+    BlobView view = {blob->data(), blob->num(), blob->channels(), blob->height(), blob->width(), blob->layout()};
+    return view;
+}
+
+int Net::GetBlobView(const std::string &name, BlobView *view)
+{
+    const Blob<float> *p_blob = GetBlobHandle(name);
+    if (p_blob == NULL)
+    {
+        LOGE("Cannot find blob %s\n", name.c_str());
+        return -1;
+    }
+    *view = GetBlobView(p_blob);
+    return 0;
+}
+
+int Net::BindOutput(const std::string &name, float *dst)
+{
+    const Blob<float> *p_blob = GetBlobHandle(name);
+    InputLayer *input_layer = (InputLayer *)layers[0];
+    if (p_blob == NULL || input_layer->input_blob(name) != NULL)
+    {
+        LOGE("Cannot bind output blob %s\n", name.c_str());
+        return -1;
+    }
+    OutputBinding binding = {p_blob, dst, p_blob->data_size()};
+    bound_outputs[name] = binding;
+    if (((uintptr_t) dst % kBindAlign) != 0 || p_blob->layout() != NCHW)
+    {
+        LOGD("Output %s is copied, %s\n", name.c_str(), (p_blob->layout() != NCHW) ? "the blob is packed" : "the buffer is not aligned");
+        return 1;
+    }
+    //The net only hands out const blobs, the producing layer owns this one.
+    const_cast<Blob<float> *>(p_blob)->BindData(dst, p_blob->data_size());
+    blobs_moved = true;
+    return 0;
+}
+
+void Net::CopyBoundOutputs()
+{
+    std::map<std::string, OutputBinding>::iterator it = bound_outputs.begin();
+    while (it != bound_outputs.end())
+    {
+        const OutputBinding &binding = it->second;
+        if (binding.blob->data_size() > binding.capacity)
+        {
+            LOGE("Output %s outgrew its bound buffer, binding dropped\n", it->first.c_str());
+            bound_outputs.erase(it++);
+            continue;
+        }
+        if (binding.blob->data() != binding.dst)
+            CopyBlobData(binding.dst, binding.blob, rt_param->num_threads());
+        ++it;
+    }
+}
+
 int Net::GetBlobDataSize(size_t *data_size, std::string name)
 {
     if (blob_map.find(std::string(name)) == blob_map.end())
@@ -86,62 +465,878 @@ int Net::GetBlobDataSize(size_t *data_size, std::string name)
         return -1;
     }
     const Blob<float> *p_blob = blob_map[name];
-    *data_size = p_blob->data_size();
+    *data_size = p_blob->elem_count();
     return 0;
 }
 
 int Net::Forward(float *input)
 {
     InputLayer *input_layer = (InputLayer *)layers[0];
+    std::vector<InputBinding> inputs;
     for (int i = 0; i < input_layer->input_size(); ++i)
     {
-        input_layer->CopyInput(input_layer->input_name(i), input);
+        InputBinding binding = {input_layer->input_name(i), input, 0, 0};
+        inputs.push_back(binding);
     }
-    
-    for (int i = 1; i < layers.size(); ++i)
+    return Forward(inputs);
+}
+
+int Net::Forward(float* input, int height, int width)
+{
+    InputLayer *input_layer = (InputLayer *)layers[0];
+    DetachInput(input_layer->input_name(0));
+    input_layer->Reshape(input_layer->input_name(0), height, width);
+    input_layer->CopyInput(input_layer->input_name(0), input);
+    return ForwardLayers(true);
+}
+
+int Net::Forward(const std::vector<InputBinding> &inputs)
+{
+    return Forward(inputs, std::vector<std::string>());
+}
+
+int Net::Forward(const std::vector<InputBinding> &inputs, const std::vector<std::string> &stop_at)
+{
+    return Forward(inputs, stop_at, ForwardOptions());
+}
+
+int Net::Forward(const std::vector<InputBinding> &inputs, const std::vector<std::string> &stop_at, const ForwardOptions &options)
+{
+    const size_t num_threads = rt_param->num_threads();
+    if (options.num_threads && options.num_threads != num_threads)
+        SetNumThreads(options.num_threads);
+    if (options.profile)
+        layer_ms.assign(layers.size(), -1.0);
+    int ret = ForwardInputs(inputs, stop_at);
+    if (options.profile)
     {
-#ifdef LAYER_TIMING
-        timespec tpstart, tpend;
-        clock_gettime(CLOCK_MONOTONIC, &tpstart);
-#endif
-        //LOGD("Forward layer%d:%s %s\n", i, layers[i]->name().c_str(), layers[i]->type().c_str());
-        layers[i]->Forward();
-#if 0
-        for (size_t j = 0; j < layers[i]->top_blob_size(); j++)
-            layers[i]->top_blob(j)->PrintBlobInfo();
+        //Net order is an execution order also when lanes ran side by side.
+        options.profile->clear();
+        for (size_t i = 0; i < layer_ms.size(); ++i)
+        {
+            if (layer_ms[i] < 0)
+                continue;
+            LayerTime time;
+            time.name = layers[i]->name();
+            time.type = layers[i]->type();
+            time.ms = layer_ms[i];
+            options.profile->push_back(time);
+        }
+        layer_ms.clear();
+    }
+    if (rt_param->num_threads() != num_threads)
+        SetNumThreads(num_threads);
+    return ret;
+}
+
+int Net::ForwardInputs(const std::vector<InputBinding> &inputs, const std::vector<std::string> &stop_at)
+{
+    const std::vector<size_t> *order = NULL;
+    if (!LayersFor(stop_at, &order))
+        return -1;
+    InputLayer *input_layer = (InputLayer *)layers[0];
+    bool reshape = false;
+    for (size_t i = 0; i < inputs.size(); ++i)
+    {
+        const Blob<float> *p_blob = input_layer->input_blob(inputs[i].name);
+        if (p_blob == NULL)
+        {
+            LOGE("Cannot find input blob %s\n", inputs[i].name.c_str());
+            return -1;
+        }
+        DetachInput(inputs[i].name);
+        if ((inputs[i].height && inputs[i].height != p_blob->height()) || (inputs[i].width && inputs[i].width != p_blob->width()))
+        {
+            input_layer->Reshape(inputs[i].name, inputs[i].height ? inputs[i].height : p_blob->height(),
+                                 inputs[i].width ? inputs[i].width : p_blob->width());
+            reshape = true;
+        }
+        input_layer->CopyInput(inputs[i].name, inputs[i].data);
+    }
+    //Inputs BindInput had to copy.
+    std::map<std::string, InputBinding>::iterator it;
+    for (it = copied_inputs.begin(); it != copied_inputs.end(); ++it)
+        input_layer->CopyInput(it->first, it->second.data);
+    return ForwardLayers(reshape, *order);
+}
+
+int Net::Forward()
+{
+    return Forward(std::vector<InputBinding>(), std::vector<std::string>());
+}
+
+/*
+ * Walks the layers backwards from the requested blobs, a layer is needed when it writes one of
+ * the blobs still wanted, which adds its bottoms. An empty list means every layer.
+ */
+bool Net::LayersFor(const std::vector<std::string> &blobs, const std::vector<size_t> **order)
+{
+    std::vector<std::string> key(blobs);
+    std::sort(key.begin(), key.end());
+    key.erase(std::unique(key.begin(), key.end()), key.end());
+    std::map<std::vector<std::string>, std::vector<size_t> >::iterator it = layer_orders.find(key);
+    if (it != layer_orders.end())
+    {
+        *order = &it->second;
+        return true;
+    }
+    std::set<std::string> wanted;
+    for (size_t i = 0; i < key.size(); ++i)
+    {
+        if (blob_map.find(key[i]) == blob_map.end())
+        {
+            LOGE("Cannot find blob %s\n", key[i].c_str());
+            return false;
+        }
+        wanted.insert(key[i]);
+    }
+    std::vector<size_t> needed;
+    for (size_t i = layers.size(); i-- > 1;)
+    {
+        bool need = key.empty();
+        for (size_t t = 0; t < layers[i]->top_size() && !need; ++t)
+            need = wanted.count(layers[i]->top(t)) > 0;
+        if (!need)
+            continue;
+        needed.push_back(i);
+        for (size_t b = 0; b < layers[i]->bottom_size(); ++b)
+            wanted.insert(layers[i]->bottom(b));
+    }
+    std::reverse(needed.begin(), needed.end());
+    if (!key.empty())
+        LOGD("Forward up to %zu blobs runs %zu of %zu layers\n", key.size(), needed.size(), layers.size() - 1);
+    *order = &(layer_orders[key] = needed);
+    return true;
+}
+
+
+int Net::BindInput(const std::string &name, float *data, size_t height, size_t width)
+{
+    InputLayer *input_layer = (InputLayer *)layers[0];
+    const Blob<float> *p_blob = input_layer->input_blob(name);
+    if (p_blob == NULL)
+    {
+        LOGE("Cannot find input blob %s\n", name.c_str());
+        return -1;
+    }
+    height = height ? height : p_blob->height();
+    width = width ? width : p_blob->width();
+    //A layer writing the input in place would modify the caller's buffer.
+    bool written = false;
+    for (size_t i = 1; i < layers.size(); ++i)
+        for (size_t t = 0; t < layers[i]->top_size(); ++t)
+            written = written || layers[i]->top(t) == name;
+    bool aligned = ((uintptr_t) data % kBindAlign) == 0;
+    if (aligned && !written)
+    {
+        copied_inputs.erase(name);
+        input_layer->BindInput(name, data, height, width);
+        blobs_moved = true;
+        return 0;
+    }
+    LOGD("Input %s is copied, %s\n", name.c_str(), written ? "a layer writes it in place" : "the buffer is not aligned");
+    DetachInput(name);
+    if (height != p_blob->height() || width != p_blob->width())
+    {
+        input_layer->Reshape(name, height, width);
+        blobs_moved = true;
+    }
+    InputBinding binding = {name, data, height, width};
+    copied_inputs[name] = binding;
+    return 1;
+}
 
-	PrintBlobData(layers[i]->name());	
+void Net::DetachInput(const std::string &name)
+{
+    InputLayer *input_layer = (InputLayer *)layers[0];
+    copied_inputs.erase(name);
+    if (input_layer->UnbindInput(name))
+        blobs_moved = true;
+}
+
+int Net::ForwardLayers(bool reshape)
+{
+    const std::vector<size_t> *order = NULL;
+    LayersFor(std::vector<std::string>(), &order);
+    return ForwardLayers(reshape, *order);
+}
+
+int Net::ForwardLayers(bool reshape, const std::vector<size_t> &order)
+{
+    //Layers skipped by partial runs reshape the next time they run.
+    if ((reshape || blobs_moved) && !resolution_plans.empty())
+        SelectPlan();
+    if (reshape || blobs_moved || reshape_pending.size() != layers.size())
+        reshape_pending.assign(layers.size(), reshape || blobs_moved);
+    blobs_moved = false;
+    if (branch_stages.empty())
+    {
+        size_t stage = 0;
+        for (size_t n = 0; n < order.size(); ++n)
+        {
+            const size_t i = order[n];
+            if (!pipeline_stages.empty() && layer_stage[i] > stage)
+            {
+                UpdateStageCopies(stage + 1, layer_stage[i], true);
+                stage = layer_stage[i];
+            }
+            RunLayer(i);
+        }
+        CopyBoundOutputs();
+        return 0;
+    }
+    std::vector<char> wanted(layers.size(), 0);
+    for (size_t n = 0; n < order.size(); ++n)
+        wanted[order[n]] = 1;
+#ifdef _OPENMP
+    //The layers of a lane open their own parallel regions, the caller's setting is restored below.
+    const int max_active_levels = omp_get_max_active_levels();
+    if (max_active_levels < 2)
+        omp_set_max_active_levels(2);
 #endif
-#ifdef LAYER_TIMING
-        clock_gettime(CLOCK_MONOTONIC, &tpend);
-        double timedif = 1000000.0 * (tpend.tv_sec - tpstart.tv_sec) + (tpend.tv_nsec - tpstart.tv_nsec) / 1000.0;
-        LOGD("layer %s type %s spent %lfms\n", layers[i]->name().c_str(), layers[i]->type().c_str(), timedif / 1000.0);
+    for (size_t s = 0; s < branch_stages.size(); ++s)
+    {
+        const std::vector<BranchLane> &lanes = branch_stages[s];
+        const int num_lanes = std::min(lanes.size(), rt_param->num_threads());
+        #pragma omp parallel for num_threads(num_lanes) schedule(static, 1) if (num_lanes > 1)
+        for (int l = 0; l < (int) lanes.size(); ++l)
+        {
+            for (size_t k = 0; k < lanes[l].layers.size(); ++k)
+            {
+                if (wanted[lanes[l].layers[k]])
+                    RunLayer(lanes[l].layers[k]);
+            }
+        }
+    }
+#ifdef _OPENMP
+    omp_set_max_active_levels(max_active_levels);
 #endif
+    CopyBoundOutputs();
+    return 0;
+}
+
+int Net::Prepare(size_t height, size_t width)
+{
+    InputLayer *input_layer = (InputLayer *)layers[0];
+    const std::string input_name = input_layer->input_name(0);
+    DetachInput(input_name);
+    input_layer->Reshape(input_name, height, width);
+    std::vector<float> zeros(input_layer->input_blob(input_name)->data_size(), 0.f);
+    input_layer->CopyInput(input_name, &zeros[0]);
+    //Binds the plan if the resolution was prepared before.
+    ForwardLayers(true);
+    std::vector<size_t> key = InputShapes();
+    if (resolution_plans.find(key) != resolution_plans.end())
+        return 0;
 
+    std::set<const Blob<float> *> kept;
+    for (size_t i = 0; i < output_blob_names.size(); ++i)
+    {
+        //Requested input blobs are not in the map, and are not planned anyway.
+        std::map<std::string, const Blob<float> *>::iterator it = blob_map.find(output_blob_names[i]);
+        if (it != blob_map.end())
+            kept.insert(it->second);
+    }
+    std::set<const Blob<float> *> bound;
+    std::map<std::string, OutputBinding>::iterator bit;
+    for (bit = bound_outputs.begin(); bit != bound_outputs.end(); ++bit)
+        bound.insert(bit->second.blob);
+    std::vector<BlobLifetime> lifetimes, planned;
+    CollectBlobLifetimes(layers, kept, lifetimes);
+    //Concurrent lanes and stages don't run in layer order, their blobs get memory of their own.
+    const bool sequential = branch_stages.empty() && pipeline_stages.empty();
+    for (size_t i = 0; i < lifetimes.size(); ++i)
+    {
+        if (lifetimes[i].layer == layers[0] || bound.find(lifetimes[i].blob) != bound.end())
+            continue;
+        BlobLifetime lifetime = lifetimes[i];
+        lifetime.size = (lifetime.blob->data_size() * sizeof(float) + kArenaAlign - 1) / kArenaAlign * kArenaAlign;
+        if (!sequential)
+        {
+            lifetime.first = 0;
+            lifetime.last = layers.size();
+        }
+        planned.push_back(lifetime);
+    }
+    ResolutionPlan plan;
+    plan.activation_size = PlaceBlobs(planned, plan.offsets);
+    plan.scratch_size = (rt_param->common_mempool()->GetSize() + kArenaAlign - 1) / kArenaAlign * kArenaAlign;
+    plan.arena = (float *) _mm_malloc(plan.activation_size + plan.scratch_size, kArenaAlign);
+    if (!plan.arena)
+    {
+        LOGE("Cannot allocate the arena of resolution %zux%zu\n", height, width);
+        return -1;
+    }
+    for (size_t i = 0; i < planned.size(); ++i)
+    {
+        plan.blobs.push_back(planned[i].blob);
+        plan.sizes.push_back(planned[i].size);
+    }
+    plan.last_use = ++plan_clock;
+    BindPlan(&(resolution_plans[key] = plan));
+    LOGD("Prepared resolution %zux%zu, arena of %zu bytes\n", height, width, plan.activation_size + plan.scratch_size);
+
+    while (resolution_plans.size() > std::max(max_plans, (size_t) 1))
+    {
+        std::map<std::vector<size_t>, ResolutionPlan>::iterator oldest = resolution_plans.begin();
+        std::map<std::vector<size_t>, ResolutionPlan>::iterator it;
+        for (it = resolution_plans.begin(); it != resolution_plans.end(); ++it)
+            oldest = (it->second.last_use < oldest->second.last_use) ? it : oldest;
+        free(oldest->second.arena);
+        resolution_plans.erase(oldest);
     }
     return 0;
 }
 
-int Net::Forward(float* input, int height, int width)
+int Net::ReserveShapes(size_t max_height, size_t max_width)
 {
     InputLayer *input_layer = (InputLayer *)layers[0];
-    input_layer->Reshape(input_layer->input_name(0), height, width);
-    input_layer->CopyInput(input_layer->input_name(0), input);
-    for (int i = 1; i < layers.size(); ++i)
+    const std::string input_name = input_layer->input_name(0);
+    const Blob<float> *input_blob = input_layer->input_blob(input_name);
+    const size_t height = input_blob->height();
+    const size_t width = input_blob->width();
+    DetachInput(input_name);
+    input_layer->Reshape(input_name, max_height, max_width);
+    std::vector<float> zeros(input_blob->data_size(), 0.f);
+    input_layer->CopyInput(input_name, &zeros[0]);
+    //Blobs and scratch only grow, the reshapes on the way leave them at the largest size.
+    int ret = ForwardLayers(true);
+    input_layer->Reshape(input_name, height, width);
+    blobs_moved = true;
+    return ret;
+}
+
+std::vector<size_t> Net::InputShapes()
+{
+    InputLayer *input_layer = (InputLayer *)layers[0];
+    std::vector<size_t> shapes;
+    for (int i = 0; i < input_layer->input_size(); ++i)
+    {
+        const Blob<float> *p_blob = input_layer->input_blob(input_layer->input_name(i));
+        shapes.push_back(p_blob->height());
+        shapes.push_back(p_blob->width());
+    }
+    return shapes;
+}
+
+void Net::SelectPlan()
+{
+    std::map<std::vector<size_t>, ResolutionPlan>::iterator it = resolution_plans.find(InputShapes());
+    if (it == resolution_plans.end())
+        return;
+    it->second.last_use = ++plan_clock;
+    if (&it->second != active_plan)
+        BindPlan(&it->second);
+}
+
+void Net::BindPlan(ResolutionPlan *plan)
+{
+    std::set<const Blob<float> *> bound;
+    std::map<std::string, OutputBinding>::iterator it;
+    for (it = bound_outputs.begin(); it != bound_outputs.end(); ++it)
+        bound.insert(it->second.blob);
+    for (size_t i = 0; i < plan->blobs.size(); ++i)
+    {
+        if (bound.find(plan->blobs[i]) == bound.end())
+            plan->blobs[i]->BindData(plan->arena + plan->offsets[i] / sizeof(float), plan->sizes[i] / sizeof(float));
+    }
+    if (plan->scratch_size > 0)
+        rt_param->common_mempool()->Attach(plan->arena + plan->activation_size / sizeof(float), plan->scratch_size);
+    active_plan = plan;
+    blobs_moved = true;
+}
+
+int Net::ForwardPipelined(const std::vector<const float *> &frames, const std::vector<std::string> &outputs,
+                          const std::vector<float *> &results)
+{
+    if (results.size() < frames.size() * outputs.size())
+    {
+        LOGE("ForwardPipelined needs %zu result buffers, got %zu\n", frames.size() * outputs.size(), results.size());
+        return -1;
+    }
+    std::vector<const Blob<float> *> output_blobs;
+    std::vector<size_t> output_stages;
+    for (size_t j = 0; j < outputs.size(); ++j)
+    {
+        std::map<std::string, const Blob<float> *>::iterator it = blob_map.find(outputs[j]);
+        if (it == blob_map.end())
+        {
+            LOGE("Cannot find blob %s\n", outputs[j].c_str());
+            return -1;
+        }
+        output_blobs.push_back(it->second);
+        //A frame's output is final once the stage of its last writer ran on it.
+        size_t stage = 0;
+        for (size_t i = 1; i < layers.size() && !pipeline_stages.empty(); ++i)
+        {
+            for (size_t t = 0; t < layers[i]->top_size(); ++t)
+                stage = (layers[i]->top(t) == outputs[j]) ? layer_stage[i] : stage;
+        }
+        output_stages.push_back(stage);
+    }
+    InputLayer *input_layer = (InputLayer *)layers[0];
+    const std::string input_name = input_layer->input_name(0);
+    DetachInput(input_name);
+    std::map<std::string, InputBinding>::iterator it;
+    for (it = copied_inputs.begin(); it != copied_inputs.end(); ++it)
+        input_layer->CopyInput(it->first, it->second.data);
+    if (pipeline_stages.empty())
     {
+        for (size_t f = 0; f < frames.size(); ++f)
+        {
+            input_layer->CopyInput(input_name, frames[f]);
+            ForwardLayers(false);
+            for (size_t j = 0; j < outputs.size(); ++j)
+                CopyBlobData(results[f * outputs.size() + j], output_blobs[j], rt_param->num_threads());
+        }
+        return 0;
+    }
+
+    if (blobs_moved || reshape_pending.size() != layers.size())
+        reshape_pending.assign(layers.size(), blobs_moved);
+    blobs_moved = false;
+#ifdef _OPENMP
+    //The layers of a stage open their own parallel regions, the caller's setting is restored below.
+    const int max_active_levels = omp_get_max_active_levels();
+    if (max_active_levels < 2)
+        omp_set_max_active_levels(2);
+#endif
+    const size_t num_stages = pipeline_stages.size();
+    const int num_workers = std::min(num_stages, rt_param->num_threads());
+    for (size_t step = 0; step + 1 < frames.size() + num_stages; ++step)
+    {
+        if (step < frames.size())
+            input_layer->CopyInput(input_name, frames[step]);
+        #pragma omp parallel for num_threads(num_workers) schedule(static, 1)
+        for (int s = 0; s < (int) num_stages; ++s)
+        {
+            //Stage s works on frame step - s.
+            if (step < (size_t) s || step - s >= frames.size())
+                continue;
+            for (size_t k = 0; k < pipeline_stages[s].layers.size(); ++k)
+                RunLayer(pipeline_stages[s].layers[k]);
+        }
+        for (size_t j = 0; j < outputs.size(); ++j)
+        {
+            if (step >= output_stages[j] && step - output_stages[j] < frames.size())
+                CopyBlobData(results[(step - output_stages[j]) * outputs.size() + j], output_blobs[j], rt_param->num_threads());
+        }
+        UpdateStageCopies(1, num_stages - 1, false);
+    }
+#ifdef _OPENMP
+    omp_set_max_active_levels(max_active_levels);
+#endif
+    CopyBoundOutputs();
+    return 0;
+}
+
+void Net::UpdateStageCopies(size_t first, size_t last, bool from_source)
+{
+    //Later stages first, a copy hands its frame on before taking the next one.
+    for (size_t s = last + 1; s-- > first;)
+    {
+        for (size_t c = 0; c < stage_copies.size(); ++c)
+        {
+            StageCopy &copy = stage_copies[c];
+            if (copy.stage != s)
+                continue;
+            const Blob<float> *from = from_source ? copy.source : copy.previous;
+            if (from->num() != copy.blob->num() || from->channels() != copy.blob->channels()
+                    || from->height() != copy.blob->height() || from->width() != copy.blob->width())
+            {
+                copy.blob->ReshapeWithRealloc(from);
+                for (size_t r = 0; r < copy.readers.size(); ++r)
+                    reshape_pending[copy.readers[r]] = true;
+            }
+            copy.blob->CopyData(from->data());
+        }
+    }
+}
+
+void Net::RunLayer(size_t i)
+{
 #ifdef LAYER_TIMING
-        timespec tpstart, tpend;
-        clock_gettime(CLOCK_MONOTONIC, &tpstart);
+    timespec tpstart, tpend;
+    clock_gettime(CLOCK_MONOTONIC, &tpstart);
 #endif
-// LOGI("Forward layer%d:%s %s\n", i, layers[i]->name().c_str(), layers[i]->type().c_str());
+    //LOGD("Forward layer%d:%s %s\n", i, layers[i]->name().c_str(), layers[i]->type().c_str());
+    timespec start, end;
+    if (!layer_ms.empty())
+        clock_gettime(CLOCK_MONOTONIC, &start);
+    if (reshape_pending[i])
         layers[i]->ForwardReshape();
+    else
+        layers[i]->Forward();
+    reshape_pending[i] = false;
+    //Lanes running side by side time distinct layers.
+    if (!layer_ms.empty())
+    {
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        layer_ms[i] = 1000.0 * (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1000000.0;
+    }
 #ifdef LAYER_TIMING
-        clock_gettime(CLOCK_MONOTONIC, &tpend);
-        double timedif = 1000000.0 * (tpend.tv_sec - tpstart.tv_sec) + (tpend.tv_nsec - tpstart.tv_nsec) / 1000.0;
-        LOGI("layer %s type %s spent %lfms\n", layers[i]->name().c_str(), layers[i]->type().c_str(), timedif / 1000.0);
+    clock_gettime(CLOCK_MONOTONIC, &tpend);
+    double timedif = 1000000.0 * (tpend.tv_sec - tpstart.tv_sec) + (tpend.tv_nsec - tpstart.tv_nsec) / 1000.0;
+    LOGD("layer %s type %s spent %lfms\n", layers[i]->name().c_str(), layers[i]->type().c_str(), timedif / 1000.0);
 #endif
+}
+
+/*
+ * Chains of layers each feeding only the next one run as a unit. A chain's stage is one past the
+ * latest stage it depends on, the chains of a stage are independent. They are spread over at most
+ * num_threads lanes, largest first onto the lane with the least work, and the threads are split
+ * by the work of the lanes. Lanes get a scratch pool each since their layers run at the same time.
+ */
+void Net::PlanBranches()
+{
+    const size_t num_threads = rt_param->num_threads();
+    std::vector<std::set<size_t> > deps;
+    CollectLayerDependencies(layers, deps);
+    std::vector<size_t> dependents(layers.size(), 0);
+    for (size_t i = 1; i < layers.size(); ++i)
+    {
+        for (std::set<size_t>::iterator it = deps[i].begin(); it != deps[i].end(); ++it)
+            ++dependents[*it];
     }
-    return 0;
+    std::vector<std::vector<size_t> > chains;
+    std::vector<size_t> chain_stage;
+    std::vector<size_t> chain_of(layers.size(), 0);
+    size_t num_stages = 0;
+    for (size_t i = 1; i < layers.size(); ++i)
+    {
+        if (deps[i].size() == 1 && dependents[*deps[i].begin()] == 1)
+        {
+            chain_of[i] = chain_of[*deps[i].begin()];
+            chains[chain_of[i]].push_back(i);
+            continue;
+        }
+        size_t stage = 0;
+        for (std::set<size_t>::iterator it = deps[i].begin(); it != deps[i].end(); ++it)
+            stage = std::max(stage, chain_stage[chain_of[*it]] + 1);
+        chain_of[i] = chains.size();
+        chains.push_back(std::vector<size_t>(1, i));
+        chain_stage.push_back(stage);
+        num_stages = std::max(num_stages, stage + 1);
+    }
+
+    branch_stages.assign(num_stages, std::vector<BranchLane>());
+    size_t concurrent = 0;
+    for (size_t s = 0; s < num_stages; ++s)
+    {
+        std::vector<std::pair<double, size_t> > work;
+        for (size_t c = 0; c < chains.size(); ++c)
+        {
+            if (chain_stage[c] != s)
+                continue;
+            double flops = 0;
+            for (size_t k = 0; k < chains[c].size(); ++k)
+                flops += EstimateFlops(layers[chains[c][k]]);
+            work.push_back(std::make_pair(-flops, c));
+        }
+        std::sort(work.begin(), work.end());
+        std::vector<BranchLane> &lanes = branch_stages[s];
+        std::vector<double> costs(std::min(work.size(), num_threads), 0);
+        lanes.resize(costs.size());
+        for (size_t w = 0; w < work.size(); ++w)
+        {
+            size_t l = std::min_element(costs.begin(), costs.end()) - costs.begin();
+            costs[l] -= work[w].first;
+            lanes[l].layers.insert(lanes[l].layers.end(), chains[work[w].second].begin(), chains[work[w].second].end());
+        }
+        for (size_t l = 0; l < lanes.size(); ++l)
+        {
+            //Chains of a stage are independent, net order keeps each chain in order.
+            std::sort(lanes[l].layers.begin(), lanes[l].layers.end());
+            lanes[l].flops = costs[l];
+            while (l > lane_mempools.size())
+                lane_mempools.push_back(new CommonMemPool<float>());
+            for (size_t k = 0; k < lanes[l].layers.size(); ++k)
+                layers[lanes[l].layers[k]]->SetCommonMemPool(l ? lane_mempools[l - 1] : rt_param->common_mempool());
+        }
+        SplitLaneThreads(lanes, num_threads);
+        concurrent += (lanes.size() > 1) ? 1 : 0;
+    }
+    if (concurrent == 0)
+        branch_stages.clear();
+    LOGD("%zu of %zu stages run concurrent branches\n", concurrent, num_stages);
+}
+
+/*
+ * Cuts go where the FLOPs before them come closest to an equal share. There is no cut between two
+ * writers of a blob, so in-place layers write the blob the readers of their stage see. Stages get
+ * threads by their FLOPs and a scratch pool each. A blob read across cuts gets a copy in every
+ * stage from the one after its producer to the reader's.
+ */
+void Net::PlanPipeline()
+{
+    const size_t num_layers = layers.size();
+    const size_t num_threads = rt_param->num_threads();
+    std::vector<double> prefix(num_layers, 0);
+    for (size_t i = 1; i < num_layers; ++i)
+        prefix[i] = prefix[i - 1] + EstimateFlops(layers[i]);
+    //Whether the stage may start at layer i.
+    std::vector<bool> allowed(num_layers, true);
+    std::map<std::string, size_t> writer;
+    for (size_t i = 0; i < num_layers; ++i)
+    {
+        for (size_t t = 0; t < layers[i]->top_size(); ++t)
+        {
+            std::map<std::string, size_t>::iterator it = writer.find(layers[i]->top(t));
+            if (it != writer.end())
+                std::fill(allowed.begin() + it->second + 1, allowed.begin() + i + 1, false);
+            writer[layers[i]->top(t)] = i;
+        }
+    }
+    const size_t depth = std::min(std::min(pipeline_depth, num_threads), num_layers - 1);
+    std::vector<size_t> starts(1, 1);
+    for (size_t k = 1; k < depth; ++k)
+    {
+        const double target = prefix[num_layers - 1] * k / depth;
+        size_t best = 0;
+        for (size_t i = starts.back() + 1; i < num_layers; ++i)
+        {
+            if (allowed[i] && (best == 0 || fabs(prefix[i - 1] - target) < fabs(prefix[best - 1] - target)))
+                best = i;
+        }
+        if (best == 0)
+            break;
+        starts.push_back(best);
+    }
+    if (starts.size() < 2)
+    {
+        LOGD("No place to cut the net into pipeline stages\n");
+        return;
+    }
+    starts.push_back(num_layers);
+
+    const size_t num_stages = starts.size() - 1;
+    pipeline_stages.assign(num_stages, BranchLane());
+    layer_stage.assign(num_layers, 0);
+    std::vector<double> costs;
+    for (size_t s = 0; s < num_stages; ++s)
+    {
+        for (size_t i = starts[s]; i < starts[s + 1]; ++i)
+        {
+            pipeline_stages[s].layers.push_back(i);
+            layer_stage[i] = s;
+        }
+        costs.push_back(prefix[starts[s + 1] - 1] - prefix[starts[s] - 1]);
+    }
+    for (size_t s = 0; s < num_stages; ++s)
+    {
+        pipeline_stages[s].flops = costs[s];
+        while (s > lane_mempools.size())
+            lane_mempools.push_back(new CommonMemPool<float>());
+        for (size_t k = 0; k < pipeline_stages[s].layers.size(); ++k)
+            layers[pipeline_stages[s].layers[k]]->SetCommonMemPool(s ? lane_mempools[s - 1] : rt_param->common_mempool());
+    }
+    SplitLaneThreads(pipeline_stages, num_threads);
+    for (size_t s = 0; s < num_stages; ++s)
+        LOGD("Pipeline stage %zu: layers %zu to %zu, %zu threads\n", s, starts[s], starts[s + 1] - 1, pipeline_stages[s].num_threads);
+
+    std::map<const Blob<float> *, size_t> produced;
+    std::map<std::pair<const Blob<float> *, size_t>, size_t> copies;
+    for (size_t t = 0; t < layers[0]->top_size(); ++t)
+        produced[layers[0]->top_blob(t)] = 0;
+    for (size_t i = 1; i < num_layers; ++i)
+    {
+        for (size_t b = 0; b < layers[i]->bottom_size(); ++b)
+        {
+            const Blob<float> *source = layers[i]->bottom_blob(b);
+            std::map<const Blob<float> *, size_t>::iterator it = produced.find(source);
+            if (it == produced.end() || it->second >= layer_stage[i])
+                continue;
+            for (size_t s = it->second + 1; s <= layer_stage[i]; ++s)
+            {
+                if (copies.find(std::make_pair(source, s)) != copies.end())
+                    continue;
+                StageCopy copy;
+                copy.source = source;
+                copy.previous = (s == it->second + 1) ? source : stage_copies[copies[std::make_pair(source, s - 1)]].blob;
+                copy.blob = new Blob<float>();
+                copy.blob->Copy(source);
+                copy.stage = s;
+                copies[std::make_pair(source, s)] = stage_copies.size();
+                stage_copies.push_back(copy);
+            }
+            StageCopy &copy = stage_copies[copies[std::make_pair(source, layer_stage[i])]];
+            copy.readers.push_back(i);
+            layers[i]->ReplaceBottomBlob(layers[i]->bottom(b), layers[i]->bottom(b), copy.blob);
+        }
+        for (size_t t = 0; t < layers[i]->top_size(); ++t)
+            produced[layers[i]->top_blob(t)] = layer_stage[i];
+    }
+    LOGD("%zu blobs copied between pipeline stages\n", stage_copies.size());
+}
+
+void Net::SplitLaneThreads(std::vector<BranchLane> &lanes, size_t num_threads)
+{
+    std::vector<double> costs(lanes.size());
+    for (size_t l = 0; l < lanes.size(); ++l)
+        costs[l] = lanes[l].flops;
+    std::vector<size_t> threads;
+    SplitThreads(costs, num_threads, threads);
+    for (size_t l = 0; l < lanes.size(); ++l)
+    {
+        lanes[l].num_threads = threads[l];
+        for (size_t k = 0; k < lanes[l].layers.size(); ++k)
+            layers[lanes[l].layers[k]]->SetNumThreads(threads[l]);
+    }
+}
+
+void Net::SetNumThreads(size_t num_threads)
+{
+    num_threads = std::max(num_threads, (size_t) 1);
+    rt_param->set_num_threads(num_threads);
+    if (!branch_stages.empty())
+    {
+        for (size_t s = 0; s < branch_stages.size(); ++s)
+            SplitLaneThreads(branch_stages[s], num_threads);
+    }
+    else if (!pipeline_stages.empty())
+        SplitLaneThreads(pipeline_stages, num_threads);
+    else
+    {
+        for (size_t i = 1; i < layers.size(); ++i)
+            layers[i]->SetNumThreads(num_threads);
+    }
+    //Scratch with a part per thread is sized on reshape, so more threads than ever before reshape all layers.
+    if (num_threads > reserved_threads)
+    {
+        reserved_threads = num_threads;
+        blobs_moved = true;
+    }
+}
+
+void Net::SetOutputBlobs(const std::vector<std::string> &blob_names)
+{
+    output_blob_names = blob_names;
+}
+
+void Net::SetPackedLayout(bool packed)
+{
+    packed_layout = packed;
+}
+
+void Net::SetWinogradTolerance(float tolerance)
+{
+    rt_param->set_winograd_tolerance(tolerance);
+}
+
+void Net::SetSparsityThreshold(float threshold)
+{
+    rt_param->set_sparsity_threshold(threshold);
+}
+
+void Net::SetInt8InnerProduct(bool enable)
+{
+    rt_param->set_int8_inner_product(enable);
+}
+
+void Net::SetConcurrentBranches(bool enable)
+{
+    concurrent_branches = enable;
+}
+
+void Net::SetPipelineStages(size_t stages)
+{
+    pipeline_depth = stages;
+}
+
+void Net::SetMaxPlans(size_t plans)
+{
+    max_plans = plans;
+}
+
+bool Net::PlanMemory(const std::vector<std::string> &keep_blobs, std::vector<MemoryPlanEntry> &entries,
+                     size_t *activation_size, size_t *scratch_size)
+{
+    std::set<const Blob<float> *> kept;
+    for (size_t i = 0; i < keep_blobs.size(); ++i)
+    {
+        if (blob_map.find(keep_blobs[i]) == blob_map.end())
+        {
+            LOGE("Cannot find blob %s\n", keep_blobs[i].c_str());
+            return false;
+        }
+        kept.insert(blob_map[keep_blobs[i]]);
+    }
+    std::vector<BlobLifetime> lifetimes;
+    CollectBlobLifetimes(layers, kept, lifetimes);
+    std::vector<size_t> offsets;
+    *activation_size = PlaceBlobs(lifetimes, offsets);
+
+    entries.clear();
+    for (size_t i = 0; i < lifetimes.size(); ++i)
+    {
+        MemoryPlanEntry entry;
+        entry.layer = lifetimes[i].layer->name();
+        entry.top = lifetimes[i].top;
+        entry.offset = offsets[i];
+        entry.size = lifetimes[i].size;
+        entries.push_back(entry);
+    }
+    *scratch_size = (rt_param->common_mempool()->GetSize() + kArenaAlign - 1) / kArenaAlign * kArenaAlign;
+    return true;
+}
+
+/*
+ * Binds the top blobs into one arena as laid out by an embedded plan. The plan is checked
+ * against the net as loaded, which may differ from the one it was computed for (pruned
+ * outputs, packed layout), and dropped if a blob is missing, too large or would share
+ * memory with a blob alive at the same time.
+ */
+bool Net::ApplyMemoryPlan(const void *plan_ptr)
+{
+    const MemoryPlan *memory_plan = (const MemoryPlan *) plan_ptr;
+    std::map<std::pair<std::string, size_t>, const BlobAllocation *> allocations;
+    for (size_t i = 0; i < VectorLength(memory_plan->blob()); ++i)
+    {
+        const BlobAllocation *allocation = memory_plan->blob()->Get(i);
+        allocations[std::make_pair(allocation->layer()->str(), (size_t) allocation->top())] = allocation;
+    }
+    std::vector<BlobLifetime> lifetimes;
+    CollectBlobLifetimes(layers, std::set<const Blob<float> *>(), lifetimes);
+    std::vector<const BlobAllocation *> placed;
+    for (size_t i = 0; i < lifetimes.size(); ++i)
+    {
+        std::map<std::pair<std::string, size_t>, const BlobAllocation *>::iterator it
+            = allocations.find(std::make_pair(lifetimes[i].layer->name(), lifetimes[i].top));
+        if (it == allocations.end() || it->second->size() < lifetimes[i].size
+                || it->second->offset() + it->second->size() > memory_plan->activation_size())
+        {
+            LOGD("Memory plan has no room for the blobs of layer %s\n", lifetimes[i].layer->name().c_str());
+            return false;
+        }
+        placed.push_back(it->second);
+    }
+    for (size_t i = 0; i < lifetimes.size(); ++i)
+    {
+        for (size_t j = i + 1; j < lifetimes.size(); ++j)
+        {
+            bool share = placed[i]->offset() < placed[j]->offset() + placed[j]->size()
+                         && placed[j]->offset() < placed[i]->offset() + placed[i]->size();
+            if (share && LifetimesOverlap(lifetimes[i], lifetimes[j]))
+            {
+                LOGD("Memory plan overlaps live blobs %s and %s\n", lifetimes[i].layer->top(lifetimes[i].top).c_str(),
+                     lifetimes[j].layer->top(lifetimes[j].top).c_str());
+                return false;
+            }
+        }
+    }
+
+    size_t activation_size = memory_plan->activation_size();
+    size_t scratch_size = memory_plan->scratch_size();
+    arena = (float *) _mm_malloc(activation_size + scratch_size, kArenaAlign);
+    if (!arena)
+        return false;
+    for (size_t i = 0; i < lifetimes.size(); ++i)
+        lifetimes[i].blob->BindData(arena + placed[i]->offset() / sizeof(float), placed[i]->size() / sizeof(float));
+    //Layers requesting more scratch than planned, e.g. with more threads, get their own.
+    if (scratch_size > 0)
+        rt_param->common_mempool()->Attach(arena + activation_size / sizeof(float), scratch_size);
+    LOGD("Memory plan applied, arena of %zu bytes\n", activation_size + scratch_size);
+    return true;
 }
 
 void Net::TraverseNet()
@@ -196,11 +1391,39 @@ void Net::InitFromFile(FILE* fp)
     this->InitFromBuffer(net_buffer);
     free(net_buffer);
 }
+bool Net::DropsRequestedBlob(Layer *producer, Layer *consumer)
+{
+    //In-place consumers keep the name, the requested blob is then the fused result.
+    if (consumer->top(0).compare(producer->top(0)) == 0)
+        return false;
+    return std::find(output_blob_names.begin(), output_blob_names.end(), producer->top(0)) != output_blob_names.end();
+}
+
 bool Net::InitFromBuffer(const void *net_buffer)
 {
     //rt_param in the param list just to distinguish.
     const NetParameter *net_param = feather::GetNetParameter(net_buffer);
     size_t layer_num = VectorLength(net_param->layer());
+    //Prune the layers which don't contribute to the requested outputs.
+    std::vector<bool> required(layer_num, true);
+    if (!output_blob_names.empty())
+    {
+        std::vector<std::vector<std::string> > bottoms(layer_num), tops(layer_num);
+        for (int i = 0; i < layer_num; ++i)
+        {
+            const LayerParameter *layer_param = net_param->layer()->Get(i);
+            for (int b = 0; b < VectorLength(layer_param->bottom()); ++b)
+                bottoms[i].push_back(layer_param->bottom()->Get(b)->str());
+            for (int t = 0; t < VectorLength(layer_param->top()); ++t)
+                tops[i].push_back(layer_param->top()->Get(t)->str());
+        }
+        if (!MarkRequiredLayers(bottoms, tops, output_blob_names, required))
+            return false;
+        size_t pruned = 0;
+        for (int i = 1; i < layer_num; ++i)
+            pruned += required[i] ? 0 : 1;
+        LOGD("Pruned %zu of %zu layers not contributing to the requested outputs\n", pruned, layer_num);
+    }
     //Find input layer.
     //LOGD("Loading %d layers\n", layer_num);
     for (int i = 0; i < layer_num; ++i)
@@ -211,42 +1434,54 @@ bool Net::InitFromBuffer(const void *net_buffer)
             break;
         }
     }
-    for (int i = 1; i < layer_num; ++i)
-    {
-        const LayerParameter *layer_param = net_param->layer()->Get(i);
-        Layer *new_layer = LayerRegistry::CreateLayer(layer_param, rt_param);
-        //LOGD("setup layer %s\n", layer_param->name()->c_str());
-        layers.push_back(new_layer);
-    }
-    //Generate top blobs, will check the dependency.
-    for (int i = 0; i < layers.size(); ++i)
+    //Layers are created once their bottoms exist, the factory picks some kernels by feature map size.
+    for (int i = 0; i < layer_num; ++i)
     {
-        size_t top_num = layers[i]->top_size();
-        size_t top_blob_num = layers[i]->top_blob_size();
+        if (i > 0)
+        {
+            if (!required[i])
+                continue;
+            const LayerParameter *layer_param = net_param->layer()->Get(i);
+            size_t bottom_height = 0;
+            size_t bottom_width = 0;
+            if (VectorLength(layer_param->bottom()) > 0 && blob_map.find(layer_param->bottom()->Get(0)->str()) != blob_map.end())
+            {
+                bottom_height = blob_map[layer_param->bottom()->Get(0)->str()]->height();
+                bottom_width = blob_map[layer_param->bottom()->Get(0)->str()]->width();
+            }
+            rt_param->set_bottom_shape(bottom_height, bottom_width);
+            Layer *new_layer = LayerRegistry::CreateLayer(layer_param, rt_param);
+            //LOGD("setup layer %s\n", layer_param->name()->c_str());
+            layers.push_back(new_layer);
+        }
+        Layer *layer = layers.back();
+        size_t top_num = layer->top_size();
+        size_t top_blob_num = layer->top_blob_size();
         if (top_blob_num == 0)
         {
-            for (int b = 0; b < layers[i]->bottom_size(); ++b)
+            for (int b = 0; b < layer->bottom_size(); ++b)
             {
-                std::string blob_name = layers[i]->bottom(b);
+                std::string blob_name = layer->bottom(b);
                 //LOGD("blob name %s\n", blob_name.c_str());
                 //TODO handle error: when blob_name has not been inserted into map.
                 if (blob_map.find(blob_name) != blob_map.end())
-                    layers[i]->SetupBottomBlob(blob_map[blob_name], blob_name);
+                    layer->SetupBottomBlob(blob_map[blob_name], blob_name);
                 else
                 {
                     LOGE("Blob %s not setup yet, may be casued by wrong layer order. Aborted.\n");
                     exit(-1);
                 }
             }
-            layers[i]->GenerateTopBlobs();
+            layer->GenerateTopBlobs();
         }
         for (int t = 0; t < top_num; ++t)
         {
-            std::string blob_name = layers[i]->top(t);
-            blob_map[blob_name] = layers[i]->top_blob(blob_name);
+            std::string blob_name = layer->top(t);
+            blob_map[blob_name] = layer->top_blob(blob_name);
             //blob_map[blob_name]->PrintBlobInfo();
         }
     }
+    rt_param->set_bottom_shape(0, 0);
 
     //Try to fuse some layers together
     for (int i = 1; i < layers.size() - 1; ++i)
@@ -255,9 +1490,10 @@ bool Net::InitFromBuffer(const void *net_buffer)
             continue;
         for (int j = i + 1; j < layers.size(); ++j)
         {
-            Layer *next_layer = layers[j];
-            while (layers[i]->TryFuse(next_layer) == 1)
+            while (j < layers.size() && IsSoleConsumer(layers, i, j, layers[i]->top(0)) && !DropsRequestedBlob(layers[i], layers[j])
+                   && layers[i]->TryFuse(layers[j]) == 1)
             {
+                Layer *next_layer = layers[j];
                 //Update the respective bottoms in other layers.
                 std::string new_bottom = layers[i]->top(0);
                 std::string old_bottom = next_layer->top(0);
@@ -276,12 +1512,22 @@ bool Net::InitFromBuffer(const void *net_buffer)
                 //LOGD("Erasing layer %d %s\n", j, next_layer->name().c_str());
 		delete layers[j];
                 layers.erase(layers.begin() + j);
-                next_layer = layers[j];
                 //LOGD("Layer %d after erasing: %s type %s\n", j, next_layer->name().c_str(), next_layer->type().c_str());
             }
         }
     }
 
+    if (packed_layout)
+        PlanPackedLayout(layers, rt_param);
+
+    if (net_param->memory_plan() && !ApplyMemoryPlan(net_param->memory_plan()))
+        LOGD("Memory plan doesn't match the net, keeping separate buffers\n");
+
+    if (pipeline_depth > 1 && arena == NULL && rt_param->num_threads() > 1)
+        PlanPipeline();
+    else if (concurrent_branches && arena == NULL && rt_param->num_threads() > 1)
+        PlanBranches();
+
     //Rebuild blob map
     blob_map.clear();
     for (int i = 1; i < layers.size(); ++i)
@@ -297,6 +1543,8 @@ bool Net::InitFromBuffer(const void *net_buffer)
 
     //Allocate for common mempool.
     rt_param->common_mempool()->Alloc();
+    for (size_t i = 0; i < lane_mempools.size(); ++i)
+        lane_mempools[i]->Alloc();
     return true;
 }
 };
@@ -20,6 +20,54 @@
 
 namespace feather
 {
+//Place of a top blob in the arena of a memory plan, in bytes.
+struct MemoryPlanEntry
+{
+    std::string layer;
+    size_t top;
+    size_t offset;
+    size_t size;
+};
+
+//Data for one input blob of Net::Forward. A zero height or width keeps the current shape.
+struct InputBinding
+{
+    std::string name;
+    const float *data;
+    size_t height;
+    size_t width;
+};
+
+//Read only view of a blob, valid until the next Forward. NC4HW4 blobs store channels padded to
+//a multiple of 4, in blocks of 4 interleaved channels.
+struct BlobView
+{
+    const float *data;
+    size_t num;
+    size_t channels;
+    size_t height;
+    size_t width;
+    BlobLayout layout;
+};
+
+//Time one layer took in a profiled Forward.
+struct LayerTime
+{
+    std::string name;
+    std::string type;
+    double ms;
+};
+
+//Options of a single Forward call.
+struct ForwardOptions
+{
+    ForwardOptions() : num_threads(0), profile(NULL) {}
+    //Threads for this call only, 0 keeps the net's.
+    size_t num_threads;
+    //Receives the time of every layer run, in execution order, unless NULL.
+    std::vector<LayerTime> *profile;
+};
+
 class Net
 {
     public:
@@ -31,8 +79,101 @@ class Net
         void InitFromFile(FILE *fp);
         bool InitFromBuffer(const void *net_buffer);
 
+        //Threads the layers run with from the next Forward on, also after Init*. Concurrent branches and
+        //pipeline stages split them anew. Buffers with a part per thread grow on the next run when the
+        //count exceeds any earlier one, and are kept when it shrinks.
+        void SetNumThreads(size_t num_threads);
+
+        //Restrict the net to the layers contributing to these blobs.
+        //Must be called before Init*, an empty list keeps every layer.
+        void SetOutputBlobs(const std::vector<std::string> &blob_names);
+
+        //Let the layers supporting it run on NC4HW4 activations, converting only where
+        //they meet NCHW layers. Off by default, must be called before Init*.
+        void SetPackedLayout(bool packed);
+
+        //Largest relative error accepted from Winograd convolutions, 1e-3 by default. 3x3 convolutions
+        //pick F(2x2,3x3), F(4x4,3x3) or F(6x6,3x3) by feature map size among the variants within it.
+        //Must be called before Init*.
+        void SetWinogradTolerance(float tolerance);
+
+        //Im2col convolutions and inner products whose weights have at least this fraction of
+        //all zero 4x1 blocks skip them with sparse kernels, 0.7 by default. Values above 1 keep
+        //every layer dense. Must be called before Init*.
+        void SetSparsityThreshold(float threshold);
+
+        //Store the weights of inner products not run sparse as int8 with a scale per output,
+        //dequantized against fp32 activations. Quarters the weight traffic of large fully
+        //connected layers at a small accuracy cost. Off by default, must be called before Init*.
+        void SetInt8InnerProduct(bool enable);
+
+        //Runs independent branches, e.g. the towers of an inception module or the heads of a detector,
+        //at the same time, splitting the threads between them by estimated FLOPs. Layers every later
+        //layer depends on keep all threads. Off by default, layers then run one after another. Must be
+        //called before Init*, has no effect with a memory plan, which shares memory in layer order.
+        void SetConcurrentBranches(bool enable);
+
+        //Splits the layers into up to this many consecutive stages with threads of their own, balanced
+        //by estimated FLOPs, for ForwardPipelined. 0 or 1 keeps one stage. Must be called before Init*,
+        //has no effect with a memory plan and takes precedence over SetConcurrentBranches.
+        void SetPipelineStages(size_t stages);
+
+        //Lays out every activation in one arena, sharing memory between blobs whose lifetimes
+        //don't overlap. Blobs in keep_blobs and blobs no layer reads stay valid after Forward.
+        //Call after Init*. A plan embedded in the model is applied when the net is loaded.
+        bool PlanMemory(const std::vector<std::string> &keep_blobs, std::vector<MemoryPlanEntry> &entries,
+                        size_t *activation_size, size_t *scratch_size);
+
+        //Runs the layers once with the first input at height x width, and keeps a plan for that resolution:
+        //an arena laying out the activations and scratch, blobs sharing memory once no layer reads them.
+        //Later reshapes to a prepared resolution bind its arena instead of reallocating. The net stays
+        //at the resolution. Blobs requested by SetOutputBlobs, inputs and bound outputs keep their own memory.
+        int  Prepare(size_t height, size_t width);
+        //Grows every blob and scratch buffer to what the first input at max_height x max_width needs, by
+        //running the layers once at that size, so that reshapes to inputs no larger don't allocate. The
+        //input keeps its shape, its data and a BindInput binding of it are dropped.
+        int  ReserveShapes(size_t max_height, size_t max_width);
+        //Number of resolution plans kept, the least recently used one is dropped beyond it. 4 by default.
+        void SetMaxPlans(size_t plans);
+
+        //Copies the same data into every input blob.
         int  Forward(float* input);
+        //Reshapes the first input blob and runs every layer with reshaping.
         int  Forward(float* input, int height, int width);
+        //Reshapes and fills each named input independently, inputs not listed keep their data.
+        //Layers are reshaped in one pass when any input changes shape.
+        int  Forward(const std::vector<InputBinding> &inputs);
+        //Same, running only the layers the blobs in stop_at depend on, e.g. to extract an embedding
+        //without the classifier head. Other blobs keep their data from earlier runs. The layer set
+        //is cached per list of blobs.
+        int  Forward(const std::vector<InputBinding> &inputs, const std::vector<std::string> &stop_at);
+        //Same, with options for this call.
+        int  Forward(const std::vector<InputBinding> &inputs, const std::vector<std::string> &stop_at, const ForwardOptions &options);
+        //Runs on the inputs as bound by BindInput.
+        int  Forward();
+        //Runs frames back to back, frames[f] holding the first input blob of frame f at its current shape.
+        //Pipeline stages work on consecutive frames at the same time, each reading its own copies of the
+        //blobs earlier stages produce, so a frame takes one step per stage. Output j of frame f is copied
+        //to results[f * outputs.size() + j] in NCHW, bound outputs hold the last frame.
+        int  ForwardPipelined(const std::vector<const float *> &frames, const std::vector<std::string> &outputs,
+                              const std::vector<float *> &results);
+
+        //Makes the input blob read data in place on the following Forward calls, data must stay
+        //valid until the input is fed or bound again. Buffers not 32 byte aligned, or inputs a
+        //layer writes in place, are copied on every Forward instead. A zero height or width keeps
+        //the current shape. Returns 0 when bound, 1 when copied and -1 for an unknown input.
+        int  BindInput(const std::string &name, float *data, size_t height, size_t width);
+
+        //Makes Forward leave the blob in dst, which must hold its elements at the current shape and stay
+        //valid. The producing layer writes into dst directly when it is 32 byte aligned and the blob
+        //is NCHW, otherwise the blob is copied there after every Forward. A reshape outgrowing dst
+        //drops the binding. Returns 0 when bound, 1 when copied and -1 for an unknown blob or a net input.
+        int BindOutput(const std::string &name, float *dst);
+
+        //Resolves a blob name once, for GetBlobView calls without a lookup. NULL if there is no such blob.
+        const Blob<float> *GetBlobHandle(const std::string &name);
+        static BlobView GetBlobView(const Blob<float> *blob);
+        int GetBlobView(const std::string &name, BlobView *view);
 
         void TraverseNet();
         int GetBlobDataSize(size_t* data_size, std::string blob_name);
@@ -40,7 +181,102 @@ class Net
         int ExtractBlob(float* output_ptr, std::string blob_name);//Don't forget to free this memory.
         std::map<std::string, const Blob<float> *> blob_map;
     private:
+        //Runs layers 1.. with Forward, or ForwardReshape after an input changed shape or memory.
+        int ForwardLayers(bool reshape);
+        int ForwardLayers(bool reshape, const std::vector<size_t> &order);
+        int ForwardInputs(const std::vector<InputBinding> &inputs, const std::vector<std::string> &stop_at);
+        void RunLayer(size_t i);
+        //Groups the layers into stages of concurrent lanes, picking their threads and scratch pools.
+        void PlanBranches();
+        //Heights and widths of the input blobs, the key of resolution plans.
+        std::vector<size_t> InputShapes();
+        //Binds the plan of the current input shapes if there is one.
+        void SelectPlan();
+        //Cuts the layers into pipeline stages and gives the later stages copies of the blobs they read.
+        void PlanPipeline();
+        //Brings the stage copies of the given stages up to date, from the source blob or from the copy
+        //of the stage before.
+        void UpdateStageCopies(size_t first, size_t last, bool from_source);
+        //Indices of the layers the blobs depend on, in execution order. False for an unknown blob.
+        bool LayersFor(const std::vector<std::string> &blobs, const std::vector<size_t> **order);
+        //Drops a binding of the input, before it is fed by copy.
+        void DetachInput(const std::string &name);
+        //Copies the bound outputs the layers could not write in place.
+        void CopyBoundOutputs();
+        bool ApplyMemoryPlan(const void *memory_plan);
+        //Whether fusing consumer into producer would hide a blob requested by SetOutputBlobs.
+        bool DropsRequestedBlob(Layer *producer, Layer *consumer);
+
         std::vector<Layer *> layers;
+        std::vector<std::string> output_blob_names;
+        bool packed_layout;
+        float *arena;
+        //Inputs BindInput could not bind in place, copied before every Forward.
+        std::map<std::string, InputBinding> copied_inputs;
+        //Outputs bound by BindOutput.
+        struct OutputBinding
+        {
+            const Blob<float> *blob;
+            float *dst;
+            size_t capacity;
+        };
+        std::map<std::string, OutputBinding> bound_outputs;
+        //Set when input or output blobs moved, the next run reshapes so that layers pick up the new pointers.
+        bool blobs_moved;
+        //Layers to run with ForwardReshape the next time they run, one byte each as lanes update them concurrently.
+        std::vector<char> reshape_pending;
+        std::map<std::vector<std::string>, std::vector<size_t> > layer_orders;
+        //Layers run in order with the same threads and scratch pool, the lanes of a stage run concurrently.
+        struct BranchLane
+        {
+            std::vector<size_t> layers;
+            size_t num_threads;
+            //Estimated work, the threads are split by it.
+            double flops;
+        };
+        bool concurrent_branches;
+        //Empty when the layers run one after another.
+        std::vector<std::vector<BranchLane> > branch_stages;
+        //Splits the threads over lanes by their work and hands them to the lanes' layers.
+        void SplitLaneThreads(std::vector<BranchLane> &lanes, size_t num_threads);
+        //Scratch of the lanes after the first, which uses the common pool.
+        std::vector<CommonMemPool<float> *> lane_mempools;
+        //Blob a pipeline stage reads from an earlier stage. Stages in between hold a copy too, so the
+        //blob moves down one stage per step along with its frame.
+        struct StageCopy
+        {
+            const Blob<float> *source;
+            const Blob<float> *previous;
+            Blob<float> *blob;
+            size_t stage;
+            std::vector<size_t> readers;
+        };
+        size_t pipeline_depth;
+        //Empty without pipelining, stage s uses the scratch of lane s.
+        std::vector<BranchLane> pipeline_stages;
+        std::vector<size_t> layer_stage;
+        std::vector<StageCopy> stage_copies;
+        //Arena of a resolution prepared by Prepare.
+        struct ResolutionPlan
+        {
+            float *arena;
+            size_t activation_size;
+            size_t scratch_size;
+            std::vector<Blob<float> *> blobs;
+            std::vector<size_t> offsets;
+            std::vector<size_t> sizes;
+            size_t last_use;
+        };
+        void BindPlan(ResolutionPlan *plan);
+        std::map<std::vector<size_t>, ResolutionPlan> resolution_plans;
+        size_t max_plans;
+        size_t plan_clock;
+        //Plan whose arena the blobs are bound to, NULL if none.
+        ResolutionPlan *active_plan;
+        //Largest thread count the layers' buffers were sized for.
+        size_t reserved_threads;
+        //Milliseconds per layer while a Forward is profiled, empty otherwise.
+        std::vector<double> layer_ms;
         RuntimeParameter<float> *rt_param;
 };
 };
@@ -24,11 +24,11 @@ template<typename Dtype>
 class RuntimeParameter
 {
     public:
-        RuntimeParameter() : _common_mempool(NULL), _num_threads(1)
+        RuntimeParameter() : _common_mempool(NULL), _num_threads(1), _winograd_tolerance(1e-3f), _sparsity_threshold(0.7f), _int8_inner_product(false), _bottom_height(0), _bottom_width(0)
         {
         }
         RuntimeParameter(CommonMemPool<Dtype> *common_mempool, size_t num_threads)
-            : _common_mempool(common_mempool), _num_threads(num_threads)
+            : _common_mempool(common_mempool), _num_threads(num_threads), _winograd_tolerance(1e-3f), _sparsity_threshold(0.7f), _int8_inner_product(false), _bottom_height(0), _bottom_width(0)
         {
         }
         CommonMemPool<Dtype>* common_mempool() const
@@ -39,8 +39,62 @@ class RuntimeParameter
         {
             return _num_threads;
         }
+        void set_num_threads(size_t num_threads)
+        {
+            _num_threads = num_threads;
+        }
+
+        //Largest relative error accepted from Winograd convolutions.
+        float winograd_tolerance() const
+        {
+            return _winograd_tolerance;
+        }
+        void set_winograd_tolerance(float tolerance)
+        {
+            _winograd_tolerance = tolerance;
+        }
+
+        //Fraction of zero 4x1 weight blocks from which convolutions and inner products run sparse.
+        float sparsity_threshold() const
+        {
+            return _sparsity_threshold;
+        }
+        void set_sparsity_threshold(float threshold)
+        {
+            _sparsity_threshold = threshold;
+        }
+
+        //Whether dense inner products keep their weights as int8 with a scale per output.
+        bool int8_inner_product() const
+        {
+            return _int8_inner_product;
+        }
+        void set_int8_inner_product(bool enable)
+        {
+            _int8_inner_product = enable;
+        }
+
+        //Spatial size of the first bottom of the layer being created, 0 when unknown.
+        size_t bottom_height() const
+        {
+            return _bottom_height;
+        }
+        size_t bottom_width() const
+        {
+            return _bottom_width;
+        }
+        void set_bottom_shape(size_t height, size_t width)
+        {
+            _bottom_height = height;
+            _bottom_width = width;
+        }
 
     private:
         CommonMemPool<Dtype> *_common_mempool;
         size_t _num_threads;
+        float _winograd_tolerance;
+        float _sparsity_threshold;
+        bool _int8_inner_product;
+        size_t _bottom_height;
+        size_t _bottom_width;
 };
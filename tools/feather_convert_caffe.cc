@@ -405,6 +405,7 @@ void CaffeModelWeightsConvert::SaveModelWeights()
             flatbuffers::Offset<feather::BatchNormParameter> bn_param;
             flatbuffers::Offset<feather::ScaleParameter> scale_param;
             flatbuffers::Offset<feather::SoftmaxParameter> softmax_param;
+            flatbuffers::Offset<feather::ArgMaxParameter> argmax_param;
             flatbuffers::Offset<feather::EltwiseParameter> eltwise_param;
             flatbuffers::Offset<feather::InnerProductParameter> inner_product_param;
             flatbuffers::Offset<feather::PReLUParameter> prelu_param;
@@ -412,10 +413,15 @@ void CaffeModelWeightsConvert::SaveModelWeights()
             flatbuffers::Offset<feather::FilterParameter> filter_param;
             flatbuffers::Offset<feather::ReshapeParameter> reshape_param;
 
-            if (layer_type.compare("Convolution") == 0 || (layer_type.compare("DepthwiseConvolution") == 0))
+            if (layer_type.compare("Convolution") == 0 || (layer_type.compare("DepthwiseConvolution") == 0) || (layer_type.compare("Deconvolution") == 0))
             {
                 printf("+ %s\n", layer_type.c_str());
                 auto caffe_conv_param = caffe_layer.convolution_param();
+                //Vectors have to be built before the table.
+                std::vector<uint32_t> dilation_vec(caffe_conv_param.dilation().begin(), caffe_conv_param.dilation().end());
+                flatbuffers::Offset<flatbuffers::Vector<uint32_t> > dilation_fbvec;
+                if (!dilation_vec.empty())
+                    dilation_fbvec = fbb.CreateVector<uint32_t>(dilation_vec);
                 feather::ConvolutionParameterBuilder conv_param_builder(fbb);
                 printf("bias term %d\n", caffe_conv_param.bias_term());
                 conv_param_builder.add_bias_term(caffe_conv_param.bias_term());
@@ -485,6 +491,12 @@ void CaffeModelWeightsConvert::SaveModelWeights()
                     conv_param_builder.add_pad_w(0);
                 }
 
+                if (!dilation_vec.empty())
+                {
+                    printf("+ dilation %u\n", dilation_vec[0]);
+                    conv_param_builder.add_dilation(dilation_fbvec);
+                }
+
 		if (layer_type.compare("DepthwiseConvolution") == 0)
 		{
 			layer_type = "Convolution";
@@ -597,7 +609,18 @@ void CaffeModelWeightsConvert::SaveModelWeights()
                 auto caffe_softmax_param = caffe_layer.softmax_param();
                 feather::SoftmaxParameterBuilder softmax_param_builder(fbb);
                 softmax_param_builder.add_axis(caffe_softmax_param.axis());
-		softmax_param_builder.Finish();
+                softmax_param = softmax_param_builder.Finish();
+            }
+            else if (layer_type.compare("ArgMax") == 0)
+            {
+                auto caffe_argmax_param = caffe_layer.argmax_param();
+                feather::ArgMaxParameterBuilder argmax_param_builder(fbb);
+                argmax_param_builder.add_out_max_val(caffe_argmax_param.out_max_val());
+                argmax_param_builder.add_top_k(caffe_argmax_param.top_k());
+                //Without an axis Caffe reduces over all but the batch, which the runtime reads as axis 0.
+                if (caffe_argmax_param.has_axis())
+                    argmax_param_builder.add_axis(caffe_argmax_param.axis());
+                argmax_param = argmax_param_builder.Finish();
             }
             else if (layer_type.compare("Scale") == 0)
             {
@@ -690,7 +713,7 @@ defalut:
             layer_builder.add_blobs(blobs_fbvec);
             layer_builder.add_name(layer_name_fbb);
             layer_builder.add_type(layer_type_fbb);
-            if (layer_type.compare("Convolution") == 0 || (layer_type.compare("DepthwiseConvolution") == 0))
+            if (layer_type.compare("Convolution") == 0 || (layer_type.compare("DepthwiseConvolution") == 0) || (layer_type.compare("Deconvolution") == 0))
                 layer_builder.add_convolution_param(conv_param);
             else if (layer_type.compare("LRN") == 0)
                 layer_builder.add_lrn_param(lrn_param);
@@ -706,6 +729,10 @@ defalut:
                 layer_builder.add_eltwise_param(eltwise_param);
             else if (layer_type.compare("Reshape") == 0)
                 layer_builder.add_reshape_param(reshape_param);
+            else if (layer_type.compare("Softmax") == 0)
+                layer_builder.add_softmax_param(softmax_param);
+            else if (layer_type.compare("ArgMax") == 0)
+                layer_builder.add_argmax_param(argmax_param);
             layer_vec.push_back(layer_builder.Finish());
         }
         auto layer_fbvec = fbb.CreateVector<flatbuffers::Offset<feather::LayerParameter>>(layer_vec);
@@ -0,0 +1,107 @@
+/*
+ * Embeds a memory plan into a feathermodel: shapes and scratch sizes come from loading the
+ * model with the runtime, so every fusion and algorithm choice is accounted for, and the
+ * activation offsets let the runtime place all blobs in one arena at load.
+ *
+ * Links against the runtime library, build it for the target, e.g.
+ * g++ -O2 -std=c++11 -fopenmp feather_plan_memory.cc -I../src -L<feather install>/lib -lfeather -o feather_plan_memory
+ */
+#include "../src/net.h"
+#include "../src/feather_simple_generated.h"
+
+#include <string>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+/*
+ * The original model is copied verbatim to the end of the new buffer and a new root table in
+ * front of it refers to its fields, plus the plan. Flatbuffers only refer forward, so nothing
+ * in the original model needs rewriting.
+ */
+static void EmbedMemoryPlan(flatbuffers::FlatBufferBuilder &fbb, const uint8_t *model, size_t model_size,
+                            const std::vector<feather::MemoryPlanEntry> &entries, size_t activation_size, size_t scratch_size)
+{
+    fbb.Pad(flatbuffers::PaddingBytes(model_size, sizeof(uint64_t)));
+    fbb.PushBytes(model, model_size);
+    fbb.Align(sizeof(uint64_t));
+    const flatbuffers::uoffset_t model_end = fbb.GetSize();
+    const feather::NetParameter *net_param = feather::GetNetParameter(model);
+#define MODEL_OFFSET(T, ptr) flatbuffers::Offset<T>((ptr) ? model_end - (flatbuffers::uoffset_t)((const uint8_t *)(ptr) - model) : 0)
+
+    std::vector<flatbuffers::Offset<feather::BlobAllocation> > blob_vec;
+    for (size_t i = 0; i < entries.size(); ++i)
+        blob_vec.push_back(feather::CreateBlobAllocationDirect(fbb, entries[i].layer.c_str(), entries[i].top, entries[i].offset, entries[i].size));
+    auto memory_plan = feather::CreateMemoryPlanDirect(fbb, &blob_vec, activation_size, scratch_size);
+
+    feather::NetParameterBuilder net_builder(fbb);
+    net_builder.add_memory_plan(memory_plan);
+    net_builder.add_layer(MODEL_OFFSET(flatbuffers::Vector<flatbuffers::Offset<feather::LayerParameter> >, net_param->layer()));
+    net_builder.add_input_shape(MODEL_OFFSET(flatbuffers::Vector<flatbuffers::Offset<feather::BlobShape> >, net_param->input_shape()));
+    net_builder.add_input(MODEL_OFFSET(flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String> >, net_param->input()));
+    net_builder.add_name(MODEL_OFFSET(flatbuffers::String, net_param->name()));
+#undef MODEL_OFFSET
+    fbb.Finish(net_builder.Finish());
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        printf("Usage: ./feather_plan_memory $1(input_feathermodel) $2(output_feathermodel) [$3(num_threads)] [$4...(blobs to keep after Forward)]\n");
+        printf("Blobs no layer reads are always kept, other blobs may be overwritten by later layers.\n");
+        return -1;
+    }
+    size_t num_threads = (argc > 3) ? atoi(argv[3]) : 1;
+    std::vector<std::string> keep_blobs;
+    for (int i = 4; i < argc; ++i)
+        keep_blobs.push_back(argv[i]);
+
+    FILE *fp = fopen(argv[1], "rb");
+    if (fp == NULL)
+    {
+        fprintf(stderr, "Cannot open %s\n", argv[1]);
+        return -1;
+    }
+    fseek(fp, 0, SEEK_END);
+    size_t model_size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    uint8_t *model = (uint8_t *) malloc(model_size);
+    if (fread(model, 1, model_size, fp) != model_size)
+    {
+        fprintf(stderr, "Reading %s failed\n", argv[1]);
+        return -1;
+    }
+    fclose(fp);
+
+    std::vector<feather::MemoryPlanEntry> entries;
+    size_t activation_size = 0;
+    size_t scratch_size = 0;
+    {
+        feather::Net net(num_threads);
+        if (!net.InitFromBuffer(model) || !net.PlanMemory(keep_blobs, entries, &activation_size, &scratch_size))
+        {
+            fprintf(stderr, "Planning failed\n");
+            return -1;
+        }
+    }
+    size_t total = 0;
+    for (size_t i = 0; i < entries.size(); ++i)
+        total += entries[i].size;
+    printf("%zu blobs, %zu bytes of activations in %zu bytes, %zu bytes of scratch\n", entries.size(), total, activation_size, scratch_size);
+
+    flatbuffers::FlatBufferBuilder fbb(model_size + 4096);
+    EmbedMemoryPlan(fbb, model, model_size, entries, activation_size, scratch_size);
+    fp = fopen(argv[2], "wb");
+    if (fp == NULL)
+    {
+        fprintf(stderr, "Cannot open %s\n", argv[2]);
+        return -1;
+    }
+    fwrite(fbb.GetBufferPointer(), sizeof(uint8_t), fbb.GetSize(), fp);
+    fclose(fp);
+    free(model);
+    return 0;
+}